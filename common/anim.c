@@ -0,0 +1,133 @@
+#include "anim.h"
+#include <stdio.h>
+#include <string.h>
+
+static int lookup(const char *name, const char *const *names, int count) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(name, names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+int anim_load(AnimSet *set, const char *path, const char *const *clipNames, int clipCount,
+              const char *const *eventNames, int eventCount) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        printf("Failed to open animation clips %s\n", path);
+        return -1;
+    }
+    if (clipCount > ANIM_MAX_CLIPS) clipCount = ANIM_MAX_CLIPS;
+    memset(set, 0, sizeof(*set));
+    set->clipCount = clipCount;
+
+    int loaded[ANIM_MAX_CLIPS] = {0};
+    int keyCount = 0;
+    int lineNo = 0;
+    char line[512];
+
+    while (fgets(line, sizeof(line), f)) {
+        lineNo++;
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+
+        char *name = strtok(line, " \t\r\n");
+        if (!name) continue;
+        char *mode = strtok(NULL, " \t\r\n");
+        int clip = lookup(name, clipNames, clipCount);
+        if (clip < 0 || !mode || (strcmp(mode, "loop") != 0 && strcmp(mode, "once") != 0)) {
+            printf("%s:%d: bad clip line\n", path, lineNo);
+            fclose(f);
+            return -1;
+        }
+
+        AnimClip *c = &set->clips[clip];
+        c->first = keyCount;
+        c->count = 0;
+        c->loop = strcmp(mode, "loop") == 0;
+
+        char *tok;
+        while ((tok = strtok(NULL, " \t\r\n")) != NULL) {
+            unsigned frame, ms;
+            char event[32] = "";
+            if (sscanf(tok, "%u:%u:%31s", &frame, &ms, event) < 2 || keyCount == ANIM_MAX_KEYS) {
+                printf("%s:%d: bad key '%s'\n", path, lineNo, tok);
+                fclose(f);
+                return -1;
+            }
+            AnimKey *k = &set->keys[keyCount++];
+            k->frame = (Uint16)frame;
+            k->ms = (Uint16)(ms ? ms : 1);
+            k->event = -1;
+            if (event[0]) {
+                k->event = (Sint16)lookup(event, eventNames, eventCount);
+                if (k->event < 0) {
+                    printf("%s:%d: unknown event '%s'\n", path, lineNo, event);
+                    fclose(f);
+                    return -1;
+                }
+            }
+            c->count++;
+        }
+        loaded[clip] = c->count > 0;
+    }
+    fclose(f);
+
+    for (int i = 0; i < clipCount; i++) {
+        if (!loaded[i]) {
+            printf("%s: clip '%s' missing or empty\n", path, clipNames[i]);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int anim_max_frame(const AnimSet *set, int clip) {
+    const AnimClip *c = &set->clips[clip];
+    int max = 0;
+    for (int i = 0; i < c->count; i++) {
+        if (set->keys[c->first + i].frame > max) max = set->keys[c->first + i].frame;
+    }
+    return max;
+}
+
+void anim_play(AnimState *s, int clip) {
+    if (s->clip != clip) anim_restart(s, clip);
+}
+
+void anim_restart(AnimState *s, int clip) {
+    s->clip = (Sint16)clip;
+    s->event = -1;
+    s->key = 0;
+    s->done = 0;
+    s->elapsed = 0;
+}
+
+void anim_update(const AnimSet *set, AnimState *states, int count, Uint32 dtMs) {
+    if (dtMs > ANIM_MAX_STEP_MS) dtMs = ANIM_MAX_STEP_MS;
+
+    for (int i = 0; i < count; i++) {
+        AnimState *s = &states[i];
+        const AnimClip *c = &set->clips[s->clip];
+        const AnimKey *keys = &set->keys[c->first];
+
+        // A freshly started clip enters its first key on this update
+        s->event = (s->key == 0 && s->elapsed == 0 && !s->done) ? keys[0].event : -1;
+        if (s->done) continue;
+
+        s->elapsed += dtMs;
+        while (s->elapsed >= keys[s->key].ms) {
+            if (s->key + 1 < c->count) {
+                s->elapsed -= keys[s->key].ms;
+                s->key++;
+            } else if (c->loop) {
+                s->elapsed -= keys[s->key].ms;
+                s->key = 0;
+            } else {
+                s->elapsed = keys[s->key].ms;
+                s->done = 1;
+                break;
+            }
+            if (keys[s->key].event >= 0) s->event = keys[s->key].event;
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef ANIM_H
+#define ANIM_H
+
+#include <SDL/SDL.h>
+
+// Time-driven animation clips loaded from a small text file, one clip per
+// line:
+//
+//   # name   mode   frame:ms[:event] ...
+//   walk     loop   0:100 1:100 2:100
+//   attack   once   0:100 1:100:hit 2:100
+//
+// Clip and event names are resolved against the tables the game passes to
+// anim_load, so clip and event ids are the game's own enum values.
+
+#define ANIM_MAX_CLIPS 16
+#define ANIM_MAX_KEYS 256
+#define ANIM_MAX_STEP_MS 250    // longer stalls are clamped, not skipped through
+
+typedef struct {
+    Uint16 frame;
+    Uint16 ms;
+    Sint16 event;   // -1: none, fired when playback enters this key
+} AnimKey;
+
+typedef struct {
+    int first, count;   // range in AnimSet.keys
+    int loop;
+} AnimClip;
+
+typedef struct {
+    AnimKey keys[ANIM_MAX_KEYS];
+    AnimClip clips[ANIM_MAX_CLIPS];
+    int clipCount;
+} AnimSet;
+
+// Per-entity playback state. Keep these in one array and update them together.
+// A zeroed state plays clip 0 from its start.
+typedef struct {
+    Sint16 clip;
+    Sint16 event;       // event entered by the last update, -1 if none
+    Uint16 key;
+    Uint16 done;        // once-clips hold their last key and set this
+    Uint32 elapsed;     // ms spent in the current key
+} AnimState;
+
+int  anim_load(AnimSet *set, const char *path, const char *const *clipNames, int clipCount,
+               const char *const *eventNames, int eventCount);
+// Highest frame index any key of `clip` uses, for checking sprite tables
+int  anim_max_frame(const AnimSet *set, int clip);
+
+// Switches clip only if it differs; anim_restart always starts over
+void anim_play(AnimState *s, int clip);
+void anim_restart(AnimState *s, int clip);
+void anim_update(const AnimSet *set, AnimState *states, int count, Uint32 dtMs);
+
+static inline int anim_frame(const AnimSet *set, const AnimState *s) {
+    return set->keys[set->clips[s->clip].first + s->key].frame;
+}
+
+#endif
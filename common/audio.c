@@ -0,0 +1,213 @@
+#include "audio.h"
+#include <string.h>
+
+// Called by SDL_mixer in place of its music player, with the audio locked.
+// Only copies out of the stream rings; decoding happens on their threads.
+static void mixHook(void *udata, Uint8 *stream, int len) {
+    AudioManager *am = udata;
+    Sint16 *dst = (Sint16 *)stream;
+    int ch = am->channels;
+    int block = AUDIO_SCRATCH / am->frameBytes * am->frameBytes;
+
+    while (len > 0) {
+        int bytes = len < block ? len : block;
+        int frames = bytes / am->frameBytes;
+        if (am->in) stream_read(&am->in->stream, am->inBuf, bytes);
+        if (am->out) stream_read(&am->out->stream, am->outBuf, bytes);
+
+        for (int f = 0; f < frames; f++) {
+            // Gain of the incoming track, 16.16, recomputed every sample frame
+            Sint32 gain = 65536;
+            if (am->fadeDone < am->fadeFrames) {
+                gain = (Sint32)(((Sint64)am->fadeDone << 16) / am->fadeFrames);
+                am->fadeDone++;
+            } else if (am->out) {
+                am->out = NULL;
+            }
+            const Sint16 *a = am->in ? (const Sint16 *)am->inBuf + f * ch : NULL;
+            const Sint16 *b = am->out ? (const Sint16 *)am->outBuf + f * ch : NULL;
+            for (int c = 0; c < ch; c++) {
+                Sint32 s = 0;
+                if (a) s += (a[c] * gain) >> 16;
+                if (b) s += (b[c] * (65536 - gain)) >> 16;
+                dst[f * ch + c] = s > 32767 ? 32767 : s < -32768 ? -32768 : s;
+            }
+        }
+        dst += frames * ch;
+        len -= bytes;
+    }
+}
+
+// Caller holds am->lock
+static void startTrack(AudioManager *am, AudioTrack *t) {
+    am->wanted = NULL;
+    am->playing = t;
+    am->switches++;
+    if (t->streamed) {
+        if (!am->hooked) {
+            Mix_HaltMusic();
+            Mix_HookMusic(mixHook, am);
+            am->hooked = 1;
+        }
+        SDL_LockAudio();
+        am->out = am->in;
+        am->in = t;
+        am->fadeDone = 0;       // the first track fades in from silence
+        SDL_UnlockAudio();
+    } else if (t->music) {
+        if (am->hooked) {
+            Mix_HookMusic(NULL, NULL);
+            am->hooked = 0;
+            am->in = am->out = NULL;
+        }
+        Mix_FadeInMusic(t->music, -1, am->fadeMs);
+    }
+}
+
+static AudioTrack *findTrack(AudioManager *am, const char *path) {
+    for (int i = 0; i < AUDIO_CACHE; i++) {
+        if (am->tracks[i].state != TRACK_EMPTY && strcmp(am->tracks[i].path, path) == 0) return &am->tracks[i];
+    }
+    return NULL;
+}
+
+// Reuses the least recently used track nobody is listening to
+static AudioTrack *claimTrack(AudioManager *am, const char *path) {
+    AudioTrack *t = findTrack(am, path);
+    if (t) return t;
+
+    AudioTrack *victim = NULL;
+    for (int i = 0; i < AUDIO_CACHE; i++) {
+        AudioTrack *c = &am->tracks[i];
+        if (c->state == TRACK_QUEUED || c->state == TRACK_LOADING) continue;
+        if (c == am->playing || c == am->wanted) continue;
+        SDL_LockAudio();
+        int audible = c == am->in || c == am->out;
+        SDL_UnlockAudio();
+        if (audible) continue;
+        if (!victim || c->state == TRACK_EMPTY || (victim->state != TRACK_EMPTY && c->lastUsed < victim->lastUsed)) victim = c;
+    }
+    if (!victim) return NULL;
+
+    if (victim->streamed) stream_close(&victim->stream);
+    if (victim->music) Mix_FreeMusic(victim->music);
+    memset(victim, 0, sizeof(*victim));
+    strncpy(victim->path, path, AUDIO_PATH - 1);
+    victim->state = TRACK_QUEUED;
+    SDL_CondSignal(am->cond);
+    return victim;
+}
+
+static int loaderMain(void *data) {
+    AudioManager *am = data;
+    SDL_mutexP(am->lock);
+    while (!am->quit) {
+        AudioTrack *t = NULL;
+        for (int i = 0; i < AUDIO_CACHE && !t; i++) {
+            if (am->tracks[i].state == TRACK_QUEUED) t = &am->tracks[i];
+        }
+        if (!t) {
+            SDL_CondWait(am->cond, am->lock);
+            continue;
+        }
+        t->state = TRACK_LOADING;
+        char path[AUDIO_PATH];
+        strcpy(path, t->path);
+        SDL_mutexV(am->lock);
+
+        // Opening and filling the ring takes a moment; nobody waits on it.
+        // A loading track is neither evicted nor heard, so its stream is ours.
+        int streamed = am->frameBytes && stream_open(&t->stream, path, 1) == 0;
+        if (streamed) stream_prime(&t->stream);
+        Mix_Music *music = streamed ? NULL : Mix_LoadMUS(path);
+
+        SDL_mutexP(am->lock);
+        t->streamed = streamed;
+        t->music = music;
+        t->state = streamed || music ? TRACK_READY : TRACK_FAILED;
+        if (t->state == TRACK_FAILED) printf("Failed to load music %s: %s\n", path, Mix_GetError());
+        if (am->wanted == t && t->state == TRACK_READY) startTrack(am, t);
+        else if (am->wanted == t) am->wanted = NULL;
+    }
+    SDL_mutexV(am->lock);
+    return 0;
+}
+
+int audio_init(AudioManager *am, Uint32 fadeMs) {
+    AudioManager empty = {0};
+    *am = empty;
+    am->fadeMs = fadeMs;
+
+    int freq, channels;
+    Uint16 format;
+    if (!Mix_QuerySpec(&freq, &format, &channels)) return -1;
+    am->channels = channels;
+    am->fadeFrames = (Uint32)freq * fadeMs / 1000;
+    // The hook mixes 16-bit samples; other formats only get the fallback
+    am->frameBytes = format == AUDIO_S16SYS ? channels * 2 : 0;
+
+    am->lock = SDL_CreateMutex();
+    am->cond = SDL_CreateCond();
+    if (am->lock && am->cond) am->thread = SDL_CreateThread(loaderMain, am);
+    if (!am->thread) {
+        printf("Failed to start music loader: %s\n", SDL_GetError());
+        return -1;
+    }
+    return 0;
+}
+
+void audio_shutdown(AudioManager *am) {
+    if (am->thread) {
+        SDL_mutexP(am->lock);
+        am->quit = 1;
+        SDL_CondSignal(am->cond);
+        SDL_mutexV(am->lock);
+        SDL_WaitThread(am->thread, NULL);
+        am->thread = NULL;
+    }
+    if (am->hooked) Mix_HookMusic(NULL, NULL);
+    Mix_HaltMusic();
+    for (int i = 0; i < AUDIO_CACHE; i++) {
+        if (am->tracks[i].streamed) stream_close(&am->tracks[i].stream);
+        if (am->tracks[i].music) Mix_FreeMusic(am->tracks[i].music);
+    }
+    if (am->cond) SDL_DestroyCond(am->cond);
+    if (am->lock) SDL_DestroyMutex(am->lock);
+    am->cond = NULL;
+    am->lock = NULL;
+}
+
+void audio_prefetch(AudioManager *am, const char *path) {
+    if (!am->thread) return;
+    SDL_mutexP(am->lock);
+    AudioTrack *t = claimTrack(am, path);
+    if (t) t->lastUsed = SDL_GetTicks();
+    SDL_mutexV(am->lock);
+}
+
+void audio_play(AudioManager *am, const char *path) {
+    if (!am->thread) return;
+    SDL_mutexP(am->lock);
+    AudioTrack *t = claimTrack(am, path);
+    if (t == am->playing) {
+        am->wanted = NULL;
+    } else if (t) {
+        t->lastUsed = SDL_GetTicks();
+        if (t->state == TRACK_READY) {
+            startTrack(am, t);
+        } else if (t->state != TRACK_FAILED) {
+            // The loader starts it when done
+            am->wanted = t;
+            am->late++;
+        }
+    }
+    SDL_mutexV(am->lock);
+}
+
+void audio_report(const AudioManager *am, FILE *out) {
+    if (!am->switches) return;
+    fprintf(out, "music: %lu switches, %lu waited for loading\n", am->switches, am->late);
+    for (int i = 0; i < AUDIO_CACHE; i++) {
+        if (am->tracks[i].streamed) stream_report(&am->tracks[i].stream, am->tracks[i].path, out);
+    }
+}
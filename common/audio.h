@@ -0,0 +1,60 @@
+#ifndef AUDIO_H
+#define AUDIO_H
+
+#include <SDL/SDL.h>
+#include <SDL/SDL_mixer.h>
+#include <stdio.h>
+#include "stream.h"
+
+// Scene music. Tracks are opened as streams (stream.h) on a loader thread and
+// the last few stay open with their ring primed, so asking for a track never
+// blocks the caller. Streamed tracks are played by our own music hook, which
+// crossfades the old track into the new one sample by sample. A track the
+// stream decoder cannot read falls back to Mix_FadeInMusic.
+
+#define AUDIO_CACHE 3
+#define AUDIO_PATH 64
+#define AUDIO_SCRATCH 8192     // bytes the hook reads from each stream at a time
+
+enum { TRACK_EMPTY, TRACK_QUEUED, TRACK_LOADING, TRACK_READY, TRACK_FAILED };
+
+typedef struct {
+    char path[AUDIO_PATH];
+    int state;
+    MusicStream stream;
+    int streamed;           // stream is open; a paused track resumes where it was
+    Mix_Music *music;       // fallback when it cannot be streamed
+    Uint32 lastUsed;
+} AudioTrack;
+
+typedef struct {
+    AudioTrack tracks[AUDIO_CACHE];
+    AudioTrack *wanted;     // asked to play, still loading
+    AudioTrack *playing;
+
+    // Owned by the audio thread while hooked; change under SDL_LockAudio
+    AudioTrack *in, *out;   // `out` fades away while `in` fades up; NULL: silent
+    Uint8 inBuf[AUDIO_SCRATCH], outBuf[AUDIO_SCRATCH];
+    Uint32 fadeFrames, fadeDone;    // fade length and progress, in sample frames
+    int hooked;
+    int channels, frameBytes;
+    Uint32 fadeMs;
+
+    SDL_Thread *thread;
+    SDL_mutex *lock;
+    SDL_cond *cond;
+    int quit;
+
+    unsigned long switches, late;   // late: the track was not ready when asked for
+} AudioManager;
+
+// After Mix_OpenAudio
+int  audio_init(AudioManager *am, Uint32 fadeMs);
+void audio_shutdown(AudioManager *am);
+// Starts loading a track that will be needed soon
+void audio_prefetch(AudioManager *am, const char *path);
+// Crossfades to the track now, or as soon as it has loaded; loops it
+void audio_play(AudioManager *am, const char *path);
+void audio_report(const AudioManager *am, FILE *out);
+
+#endif
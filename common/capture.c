@@ -0,0 +1,235 @@
+#include "capture.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <zlib.h>
+
+// B G R X in memory whatever the byte order
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+#define CAPTURE_RMASK 0x00FF0000
+#define CAPTURE_GMASK 0x0000FF00
+#define CAPTURE_BMASK 0x000000FF
+#else
+#define CAPTURE_RMASK 0x0000FF00
+#define CAPTURE_GMASK 0x00FF0000
+#define CAPTURE_BMASK 0xFF000000
+#endif
+
+static void putU32(Uint8 *p, Uint32 v) {
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+static void putU32BE(Uint8 *p, Uint32 v) {
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static int pngChunk(FILE *f, const char *type, const Uint8 *data, Uint32 len) {
+    Uint8 head[8], tail[4];
+    putU32BE(head, len);
+    memcpy(head + 4, type, 4);
+    uLong crc = crc32(0, head + 4, 4);
+    if (len) crc = crc32(crc, data, len);
+    putU32BE(tail, (Uint32)crc);
+    return fwrite(head, 8, 1, f) == 1 && (!len || fwrite(data, len, 1, f) == 1) && fwrite(tail, 4, 1, f) == 1;
+}
+
+// 8-bit RGB, every row with the Sub filter
+static int writePng(Capture *cap, const CaptureSlot *slot) {
+    char name[32];
+    snprintf(name, sizeof(name), "shot-%04d.png", ++cap->stills);
+
+    Uint8 *raw = cap->delta;
+    Uint8 *out = raw;
+    for (int y = 0; y < cap->h; y++) {
+        const Uint8 *row = (const Uint8 *)slot->surf->pixels + y * slot->surf->pitch;
+        *out++ = 1;
+        for (int x = 0; x < cap->w; x++) {
+            const Uint8 *p = row + x * 4, *left = x ? p - 4 : NULL;
+            *out++ = p[2] - (left ? left[2] : 0);
+            *out++ = p[1] - (left ? left[1] : 0);
+            *out++ = p[0] - (left ? left[0] : 0);
+        }
+    }
+    uLongf packed = cap->packedSize;
+    if (compress2(cap->packed, &packed, raw, out - raw, Z_DEFAULT_COMPRESSION) != Z_OK) return -1;
+
+    FILE *f = fopen(name, "wb");
+    if (!f) return -1;
+    static const Uint8 signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    Uint8 ihdr[13];
+    putU32BE(ihdr, cap->w);
+    putU32BE(ihdr + 4, cap->h);
+    ihdr[8] = 8;    // bits per channel
+    ihdr[9] = 2;    // RGB
+    ihdr[10] = ihdr[11] = ihdr[12] = 0;
+    int ok = fwrite(signature, 8, 1, f) == 1 && pngChunk(f, "IHDR", ihdr, 13) &&
+             pngChunk(f, "IDAT", cap->packed, packed) && pngChunk(f, "IEND", NULL, 0);
+    ok = fclose(f) == 0 && ok;
+    if (ok) cap->bytesOut += packed + 57;
+    return ok ? 0 : -1;
+}
+
+static int writeVideo(Capture *cap, const CaptureSlot *slot) {
+    Uint32 rowBytes = cap->w * 4;
+    if (!cap->video || cap->videoSession != slot->session) {
+        if (cap->video) fclose(cap->video);
+        char name[48];
+        snprintf(name, sizeof(name), "capture-%ld-%d.kbcv", (long)time(NULL), slot->session);
+        cap->video = fopen(name, "wb");
+        cap->videoSession = slot->session;
+        if (!cap->video) return -1;
+        Uint8 header[16];
+        memcpy(header, "KBCV", 4);
+        putU32(header + 4, CAPTURE_VERSION);
+        putU32(header + 8, cap->w);
+        putU32(header + 12, cap->h);
+        if (fwrite(header, sizeof(header), 1, cap->video) != 1) return -1;
+        memset(cap->prev, 0, rowBytes * cap->h);
+        cap->bytesOut += sizeof(header);
+    }
+
+    // Mostly unchanged frames XOR to mostly zeros, which zlib packs tightly
+    Uint8 *d = cap->delta, *prev = cap->prev;
+    for (int y = 0; y < cap->h; y++) {
+        const Uint8 *row = (const Uint8 *)slot->surf->pixels + y * slot->surf->pitch;
+        for (Uint32 i = 0; i < rowBytes; i++) {
+            *d++ = row[i] ^ *prev;
+            *prev++ = row[i];
+        }
+    }
+    uLongf packed = cap->packedSize;
+    if (compress2(cap->packed, &packed, cap->delta, rowBytes * cap->h, 1) != Z_OK) return -1;
+
+    Uint8 header[12];
+    putU32(header, slot->frame);
+    putU32(header + 4, slot->ticks);
+    putU32(header + 8, packed);
+    if (fwrite(header, sizeof(header), 1, cap->video) != 1 ||
+        fwrite(cap->packed, packed, 1, cap->video) != 1) return -1;
+    cap->bytesOut += sizeof(header) + packed;
+    return 0;
+}
+
+static int writerMain(void *data) {
+    Capture *cap = data;
+    for (;;) {
+        SDL_SemWait(cap->ready);
+        while (cap->tail != __atomic_load_n(&cap->head, __ATOMIC_ACQUIRE)) {
+            CaptureSlot *slot = &cap->slots[cap->tail % CAPTURE_SLOTS];
+            if ((slot->kinds & CAPTURE_STILL) && writePng(cap, slot) != 0) cap->failed++;
+            if ((slot->kinds & CAPTURE_VIDEO) && writeVideo(cap, slot) != 0) cap->failed++;
+            cap->written++;
+            __atomic_store_n(&cap->tail, cap->tail + 1, __ATOMIC_RELEASE);
+        }
+        // Caught up: whatever is on disk so far is a complete stream
+        if (cap->video) fflush(cap->video);
+        if (__atomic_load_n(&cap->quit, __ATOMIC_ACQUIRE)) break;
+    }
+    return 0;
+}
+
+int capture_open(Capture *cap, int w, int h) {
+    Capture empty = {0};
+    *cap = empty;
+    cap->w = w;
+    cap->h = h;
+    cap->videoSession = -1;
+    return 0;
+}
+
+// Buffers and writer, on the first still or recording; a failure is
+// reported once and capture stays off
+static int start(Capture *cap) {
+    if (cap->thread) return 0;
+    if (cap->startFailed) return -1;
+
+    Uint32 frameBytes = (Uint32)cap->w * cap->h * 4;
+    cap->packedSize = compressBound(frameBytes);
+    cap->prev = malloc(frameBytes);
+    cap->delta = malloc(frameBytes);
+    cap->packed = malloc(cap->packedSize);
+    int ok = cap->prev && cap->delta && cap->packed;
+    for (int i = 0; i < CAPTURE_SLOTS && ok; i++) {
+        cap->slots[i].surf = SDL_CreateRGBSurface(SDL_SWSURFACE, cap->w, cap->h, 32,
+                                                  CAPTURE_RMASK, CAPTURE_GMASK, CAPTURE_BMASK, 0);
+        ok = cap->slots[i].surf != NULL;
+    }
+    if (ok) ok = (cap->ready = SDL_CreateSemaphore(0)) != NULL;
+    if (ok) ok = (cap->thread = SDL_CreateThread(writerMain, cap)) != NULL;
+    if (!ok) {
+        printf("Failed to start capture: %s\n", SDL_GetError());
+        capture_close(cap);
+        cap->startFailed = 1;
+        return -1;
+    }
+    return 0;
+}
+
+void capture_close(Capture *cap) {
+    if (cap->thread) {
+        __atomic_store_n(&cap->quit, 1, __ATOMIC_RELEASE);
+        SDL_SemPost(cap->ready);
+        SDL_WaitThread(cap->thread, NULL);
+        cap->thread = NULL;
+    }
+    if (cap->video) fclose(cap->video);
+    cap->video = NULL;
+    if (cap->ready) SDL_DestroySemaphore(cap->ready);
+    cap->ready = NULL;
+    for (int i = 0; i < CAPTURE_SLOTS; i++) {
+        if (cap->slots[i].surf) SDL_FreeSurface(cap->slots[i].surf);
+        cap->slots[i].surf = NULL;
+    }
+    free(cap->prev);
+    free(cap->delta);
+    free(cap->packed);
+    cap->prev = cap->delta = cap->packed = NULL;
+}
+
+void capture_still(Capture *cap) {
+    if (start(cap) == 0) cap->stillWanted = 1;
+}
+
+void capture_video(Capture *cap, int on) {
+    if (on && start(cap) != 0) return;
+    if (on && !cap->recording) cap->session++;
+    cap->recording = on;
+}
+
+void capture_frame(Capture *cap, SDL_Surface *screen) {
+    cap->frame++;
+    int kinds = (cap->stillWanted ? CAPTURE_STILL : 0) | (cap->recording ? CAPTURE_VIDEO : 0);
+    if (!kinds || !cap->thread) return;
+    if (screen->w != cap->w || screen->h != cap->h) {
+        cap->dropped++;
+        return;
+    }
+    if (cap->head - __atomic_load_n(&cap->tail, __ATOMIC_ACQUIRE) == CAPTURE_SLOTS) {
+        // Writer is behind; a wanted still waits for the next frame
+        cap->dropped++;
+        return;
+    }
+
+    CaptureSlot *slot = &cap->slots[cap->head % CAPTURE_SLOTS];
+    SDL_BlitSurface(screen, NULL, slot->surf, NULL);
+    slot->kinds = kinds;
+    slot->session = cap->session;
+    slot->frame = cap->frame;
+    slot->ticks = SDL_GetTicks();
+    cap->stillWanted = 0;
+    cap->captured++;
+    __atomic_store_n(&cap->head, cap->head + 1, __ATOMIC_RELEASE);
+    SDL_SemPost(cap->ready);
+}
+
+void capture_report(const Capture *cap, FILE *out) {
+    if (!cap->captured && !cap->dropped) return;
+    fprintf(out, "capture: %lu frames captured, %lu dropped, %lu written (%lu failed), %.1f MB out\n",
+            cap->captured, cap->dropped, cap->written, cap->failed, cap->bytesOut / 1048576.0);
+}
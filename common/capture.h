@@ -0,0 +1,69 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <SDL/SDL.h>
+#include <stdio.h>
+
+// Gameplay capture. The game loop copies each presented frame into one of a
+// few buffers and goes on; a writer thread encodes them, as PNG
+// for stills and as a zlib-compressed delta stream for video. When every
+// buffer is still waiting on the writer, the frame is dropped and counted,
+// so a slow disk never holds up the loop. Works the same under the dummy
+// video driver, since it only reads the screen surface. The buffers and the
+// writer are set up by the first still or recording, so a session that never
+// captures pays for neither.
+//
+// Video file: "KBCV", version, width, height (little-endian Uint32), then per
+// frame: frame number, SDL ticks, compressed size, and the zlib-compressed
+// XOR of the frame with the previous one written (the first against black).
+// Pixels are 4 bytes, B G R unused, rows packed.
+
+#define CAPTURE_SLOTS 6
+#define CAPTURE_VERSION 1
+
+enum { CAPTURE_STILL = 1, CAPTURE_VIDEO = 2 };
+
+typedef struct {
+    SDL_Surface *surf;      // 32-bit, same size as the screen
+    int kinds;              // CAPTURE_STILL | CAPTURE_VIDEO
+    int session;            // recording this video frame belongs to
+    Uint32 frame, ticks;
+} CaptureSlot;
+
+typedef struct {
+    CaptureSlot slots[CAPTURE_SLOTS];
+    Uint32 head;            // slots ever filled, moved by the game loop
+    Uint32 tail;            // slots ever written, moved by the writer
+    int w, h;
+
+    // Game loop side
+    int stillWanted, recording, session;
+    Uint32 frame;
+
+    // Writer side
+    Uint8 *prev, *delta, *packed;
+    unsigned long packedSize;
+    FILE *video;
+    int videoSession, stills;
+
+    SDL_Thread *thread;     // NULL until the first still or recording
+    SDL_sem *ready;
+    int quit, startFailed;
+
+    unsigned long captured, dropped, written, failed;
+    Uint64 bytesOut;
+} Capture;
+
+// Only notes the size; nothing is allocated until something is captured
+int  capture_open(Capture *cap, int w, int h);
+// Writes out what is queued, then stops the writer
+void capture_close(Capture *cap);
+// The next presented frame is saved as shot-NNNN.png
+void capture_still(Capture *cap);
+// Starts a new capture-<time>-<n>.kbcv, n counting the recordings, or stops
+void capture_video(Capture *cap, int on);
+// After SDL_Flip; never waits for the writer
+void capture_frame(Capture *cap, SDL_Surface *screen);
+void capture_report(const Capture *cap, FILE *out);
+
+#endif
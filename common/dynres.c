@@ -0,0 +1,131 @@
+#include "dynres.h"
+#include "memtrack.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const int levelPct[DYNRES_LEVELS] = {100, 75, 50};
+
+#define DYNRES_DROP_FRAMES 15     // over budget this long: drop a level
+#define DYNRES_RAISE_FRAMES 90    // predicted to fit this long: go back up
+#define DYNRES_RAISE_MARGIN 85    // % of the budget the higher level must fit in
+
+void dynres_init(DynRes *dr, Uint32 budgetMs) {
+    DynRes empty = {0};
+    *dr = empty;
+    dr->budgetMs = budgetMs;
+    dr->avgMs8 = budgetMs << 8;
+}
+
+void dynres_free(DynRes *dr) {
+    for (int i = 1; i < DYNRES_LEVELS; i++) {
+        if (dr->target[i]) SDL_FreeSurface(dr->target[i]);
+        free(dr->xmap[i]);
+        dr->target[i] = NULL;
+        dr->xmap[i] = NULL;
+    }
+}
+
+int dynres_scale(const DynRes *dr) {
+    return levelPct[dr->level];
+}
+
+SDL_Surface *dynres_target(DynRes *dr, SDL_Surface *screen) {
+    int l = dr->level;
+    if (l == 0) return screen;
+
+    if (!dr->target[l]) {
+        int w = screen->w * levelPct[l] / 100, h = screen->h * levelPct[l] / 100;
+        SDL_PixelFormat *f = screen->format;
+        dr->target[l] = SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, f->BitsPerPixel,
+                                             f->Rmask, f->Gmask, f->Bmask, 0);
+        dr->xmap[l] = malloc(screen->w * sizeof(int));
+        if (!dr->target[l] || !dr->xmap[l]) {
+            // Can't afford a target: stay at full resolution
+            dynres_free(dr);
+            dr->level = 0;
+            return screen;
+        }
+        for (int x = 0; x < screen->w; x++) dr->xmap[l][x] = x * w / screen->w;
+        dr->mapW[l] = screen->w;
+    }
+    return dr->target[l];
+}
+
+void dynres_present(DynRes *dr, SDL_Surface *screen) {
+    int l = dr->level;
+    SDL_Surface *t = dr->target[l];
+    if (l == 0 || !t) return;
+
+    if (screen->format->BytesPerPixel != 4 || dr->mapW[l] != screen->w) {
+        SDL_SoftStretch(t, NULL, screen, NULL);
+        return;
+    }
+
+    // Nearest-neighbour with a precomputed column map; screen rows that come
+    // from the same target row are copied from the row above
+    const int *xmap = dr->xmap[l];
+    SDL_LockSurface(screen);
+    int prevRow = -1;
+    for (int y = 0; y < screen->h; y++) {
+        int sy = y * t->h / screen->h;
+        Uint32 *out = (Uint32 *)((Uint8 *)screen->pixels + y * screen->pitch);
+        if (sy == prevRow) {
+            memcpy(out, (Uint8 *)out - screen->pitch, screen->w * 4);
+            continue;
+        }
+        const Uint32 *in = (const Uint32 *)((const Uint8 *)t->pixels + sy * t->pitch);
+        for (int x = 0; x < screen->w; x++) out[x] = in[xmap[x]];
+        prevRow = sy;
+    }
+    SDL_UnlockSurface(screen);
+}
+
+void dynres_frame(DynRes *dr, Uint32 workMs) {
+    dr->framesAt[dr->level]++;
+    // Average over roughly the last 8 frames
+    dr->avgMs8 += ((Sint32)(workMs << 8) - (Sint32)dr->avgMs8) / 8;
+    Uint32 budget8 = dr->budgetMs << 8;
+
+    if (dr->avgMs8 > budget8 && dr->level + 1 < DYNRES_LEVELS) {
+        dr->underFrames = 0;
+        if (++dr->overFrames >= DYNRES_DROP_FRAMES) {
+            // Restart the average at the lower level's expected cost, so one
+            // slow spell does not cascade straight down to the smallest size
+            int cur = levelPct[dr->level], down = levelPct[dr->level + 1];
+            dr->avgMs8 = (Uint32)((Uint64)dr->avgMs8 * down * down / (cur * cur));
+            dr->level++;
+            dr->overFrames = 0;
+            dr->changes++;
+        }
+        return;
+    }
+    dr->overFrames = 0;
+
+    if (dr->level > 0) {
+        // Cost follows pixel count, so predict the higher level's time from
+        // the area ratio before going back up
+        int cur = levelPct[dr->level], up = levelPct[dr->level - 1];
+        Uint64 predicted = (Uint64)dr->avgMs8 * up * up / (cur * cur);
+        if (predicted * 100 < (Uint64)budget8 * DYNRES_RAISE_MARGIN) {
+            if (++dr->underFrames >= DYNRES_RAISE_FRAMES) {
+                dr->level--;
+                dr->underFrames = 0;
+                dr->avgMs8 = (Uint32)predicted;
+                dr->changes++;
+            }
+        } else {
+            dr->underFrames = 0;
+        }
+    }
+}
+
+void dynres_report(const DynRes *dr, FILE *out) {
+    unsigned long total = 0;
+    for (int i = 0; i < DYNRES_LEVELS; i++) total += dr->framesAt[i];
+    if (!total) return;
+    fprintf(out, "dynamic resolution: %d changes,", dr->changes);
+    for (int i = 0; i < DYNRES_LEVELS; i++) {
+        fprintf(out, " %d%%: %.1f%%", levelPct[i], 100.0 * dr->framesAt[i] / total);
+    }
+    fprintf(out, "\n");
+}
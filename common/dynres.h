@@ -0,0 +1,37 @@
+#ifndef DYNRES_H
+#define DYNRES_H
+
+#include <SDL/SDL.h>
+#include <stdio.h>
+
+// Dynamic resolution: the world is drawn into an internal target whose size
+// follows the measured frame time, then stretched to the screen on present.
+// Level 0 draws straight to the screen.
+
+#define DYNRES_LEVELS 3
+
+typedef struct {
+    int level;
+    Uint32 budgetMs;
+    Uint32 avgMs8;                          // frame time average, 24.8 fixed point
+    int overFrames, underFrames;
+    SDL_Surface *target[DYNRES_LEVELS];     // [0] unused
+    int *xmap[DYNRES_LEVELS];               // screen column -> target column
+    int mapW[DYNRES_LEVELS];
+    unsigned long framesAt[DYNRES_LEVELS];
+    int changes;
+} DynRes;
+
+void dynres_init(DynRes *dr, Uint32 budgetMs);
+void dynres_free(DynRes *dr);
+int  dynres_scale(const DynRes *dr);     // current target size, % of the screen
+// Surface to draw the world into this frame
+SDL_Surface *dynres_target(DynRes *dr, SDL_Surface *screen);
+// Stretches the target over the screen; nothing to do at level 0
+void dynres_present(DynRes *dr, SDL_Surface *screen);
+// Feeds the time this frame took to build, excluding any frame-rate delay.
+// May pick another level for the next frame.
+void dynres_frame(DynRes *dr, Uint32 workMs);
+void dynres_report(const DynRes *dr, FILE *out);
+
+#endif
@@ -0,0 +1,112 @@
+#include "highlight.h"
+#include <stdlib.h>
+
+#define HIGHLIGHT_LIFT 64       // of 255, how far colours move towards white
+#define HIGHLIGHT_GLOW_RADIUS 3
+#define HIGHLIGHT_SCALE_PCT 110
+
+// SDL_ConvertSurface copies the alpha channel as is, and works before a
+// video mode is set, unlike SDL_DisplayFormatAlpha
+static SDL_Surface *toARGB(SDL_Surface *src, int w, int h) {
+    SDL_Surface *fmt = SDL_CreateRGBSurface(SDL_SWSURFACE, 1, 1, 32,
+                                            0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
+    if (!fmt) return NULL;
+    SDL_Surface *out = SDL_ConvertSurface(src, fmt->format, SDL_SWSURFACE);
+    SDL_FreeSurface(fmt);
+    if (!out || (out->w == w && out->h == h)) return out;
+
+    SDL_Surface *scaled = SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, 32,
+                                               0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
+    if (scaled) SDL_SoftStretch(out, NULL, scaled, NULL);
+    SDL_FreeSurface(out);
+    return scaled;
+}
+
+static void brighten(SDL_Surface *s) {
+    for (int y = 0; y < s->h; y++) {
+        Uint32 *row = (Uint32 *)((Uint8 *)s->pixels + y * s->pitch);
+        for (int x = 0; x < s->w; x++) {
+            Uint32 p = row[x];
+            Uint32 r = (p >> 16) & 0xFF, g = (p >> 8) & 0xFF, b = p & 0xFF;
+            r += ((255 - r) * HIGHLIGHT_LIFT) >> 8;
+            g += ((255 - g) * HIGHLIGHT_LIFT) >> 8;
+            b += ((255 - b) * HIGHLIGHT_LIFT) >> 8;
+            row[x] = (p & 0xFF000000) | (r << 16) | (g << 8) | b;
+        }
+    }
+}
+
+// Transparent pixels near an opaque one become a white halo that fades with
+// distance. Buttons without transparency get the halo as an inner frame.
+static void glow(SDL_Surface *s) {
+    int w = s->w, h = s->h, R = HIGHLIGHT_GLOW_RADIUS;
+    Uint8 *alpha = malloc((size_t)w * h);
+    if (!alpha) return;
+    int opaqueOnly = 1;
+    for (int y = 0; y < h; y++) {
+        Uint32 *row = (Uint32 *)((Uint8 *)s->pixels + y * s->pitch);
+        for (int x = 0; x < w; x++) {
+            alpha[y * w + x] = row[x] >> 24;
+            if (alpha[y * w + x] < 128) opaqueOnly = 0;
+        }
+    }
+
+    for (int y = 0; y < h; y++) {
+        Uint32 *row = (Uint32 *)((Uint8 *)s->pixels + y * s->pitch);
+        for (int x = 0; x < w; x++) {
+            int d;
+            if (opaqueOnly) {
+                d = x;
+                if (w - 1 - x < d) d = w - 1 - x;
+                if (y < d) d = y;
+                if (h - 1 - y < d) d = h - 1 - y;
+                if (d >= R) continue;
+                d++;
+            } else {
+                if (alpha[y * w + x] >= 128) continue;
+                d = R + 1;
+                for (int dy = -R; dy <= R && d > 1; dy++) {
+                    for (int dx = -R; dx <= R; dx++) {
+                        int nx = x + dx, ny = y + dy;
+                        if (nx < 0 || ny < 0 || nx >= w || ny >= h || alpha[ny * w + nx] < 128) continue;
+                        int dd = abs(dx) > abs(dy) ? abs(dx) : abs(dy);
+                        if (dd < d) d = dd;
+                    }
+                }
+                if (d > R) continue;
+            }
+            Uint32 a = 255 * (R + 1 - d) / (R + 1);
+            if (opaqueOnly) {
+                // Blend the frame over the opaque image
+                Uint32 p = row[x];
+                Uint32 r = (p >> 16) & 0xFF, g = (p >> 8) & 0xFF, b = p & 0xFF;
+                r += ((255 - r) * a) >> 8;
+                g += ((255 - g) * a) >> 8;
+                b += ((255 - b) * a) >> 8;
+                row[x] = (p & 0xFF000000) | (r << 16) | (g << 8) | b;
+            } else {
+                row[x] = (a << 24) | 0x00FFFFFF;
+            }
+        }
+    }
+    free(alpha);
+}
+
+SDL_Surface *highlight_make(SDL_Surface *normal, int style) {
+    if (!normal) return NULL;
+    int w = normal->w, h = normal->h;
+    if (style == HIGHLIGHT_SCALE) {
+        w = w * HIGHLIGHT_SCALE_PCT / 100;
+        h = h * HIGHLIGHT_SCALE_PCT / 100;
+    }
+
+    SDL_Surface *out = toARGB(normal, w, h);
+    if (!out) return NULL;
+    SDL_LockSurface(out);
+    brighten(out);
+    if (style == HIGHLIGHT_GLOW) glow(out);
+    SDL_UnlockSurface(out);
+    SDL_SetAlpha(out, SDL_SRCALPHA, SDL_ALPHA_OPAQUE);
+    return out;
+}
+
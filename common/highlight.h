@@ -0,0 +1,18 @@
+#ifndef HIGHLIGHT_H
+#define HIGHLIGHT_H
+
+#include <SDL/SDL.h>
+
+// Hover images generated from a button's normal image. Build them once when
+// the button is created and keep them with it; nothing here runs per frame.
+
+enum {
+    HIGHLIGHT_BRIGHTEN,     // same size, lifted towards white
+    HIGHLIGHT_GLOW,         // brightened, plus a soft halo around the opaque edge
+    HIGHLIGHT_SCALE         // brightened and 10% larger
+};
+
+// New 32-bit ARGB surface, or NULL if `normal` is NULL or memory runs out
+SDL_Surface *highlight_make(SDL_Surface *normal, int style);
+
+#endif
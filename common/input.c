@@ -0,0 +1,101 @@
+#include "input.h"
+#include <time.h>
+
+static InputEvent queue[INPUT_QUEUE];
+static Uint32 head = 0;     // events ever pushed, moved by the filter
+static Uint32 tail = 0;     // events ever popped, moved by the game loop
+static int capturing = 0;
+static int threaded = 0;    // SDL_WasInit does not tell
+static unsigned long dropped = 0;
+
+static int probeArmed = 0;
+static Uint32 probeTime = 0;
+static unsigned long probeHist[INPUT_PROBE_BUCKETS];
+static unsigned long probeCount = 0;
+static Uint64 probeSum = 0;
+static Uint32 probeMax = 0;
+
+Uint32 input_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (Uint32)(ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
+
+// Runs on whichever thread pumps events: SDL's event thread, or the game
+// loop inside SDL_PollEvent. Either way it is the only producer.
+static int filterEvent(const SDL_Event *event) {
+    if (event->type != SDL_KEYDOWN && event->type != SDL_KEYUP) return 1;
+    if (!__atomic_load_n(&capturing, __ATOMIC_ACQUIRE)) return 1;
+
+    Uint32 h = head;
+    if (h - __atomic_load_n(&tail, __ATOMIC_ACQUIRE) == INPUT_QUEUE) {
+        dropped++;
+        return 0;
+    }
+    queue[h & (INPUT_QUEUE - 1)].event = *event;
+    queue[h & (INPUT_QUEUE - 1)].time = input_now();
+    __atomic_store_n(&head, h + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+int input_sdl_init(Uint32 flags) {
+    threaded = SDL_Init(flags | SDL_INIT_EVENTTHREAD) == 0;
+    return threaded ? 0 : SDL_Init(flags);
+}
+
+void input_start(void) {
+    SDL_SetEventFilter(filterEvent);
+    __atomic_store_n(&capturing, 1, __ATOMIC_RELEASE);
+}
+
+void input_stop(void) {
+    __atomic_store_n(&capturing, 0, __ATOMIC_RELEASE);
+    SDL_SetEventFilter(NULL);
+    // Whatever was not applied is stale now
+    __atomic_store_n(&tail, __atomic_load_n(&head, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+    probeArmed = 0;
+}
+
+int input_poll(InputEvent *out, Uint32 until) {
+    if (tail == __atomic_load_n(&head, __ATOMIC_ACQUIRE)) return 0;
+    const InputEvent *ev = &queue[tail & (INPUT_QUEUE - 1)];
+    // Stamped after the tick started: it belongs to the next one
+    if ((Sint32)(ev->time - until) > 0) return 0;
+    *out = *ev;
+    __atomic_store_n(&tail, tail + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+void input_probe_mark(Uint32 time) {
+    if (!probeArmed || (Sint32)(time - probeTime) < 0) probeTime = time;
+    probeArmed = 1;
+}
+
+void input_probe_flip(void) {
+    if (!probeArmed) return;
+    probeArmed = 0;
+    Uint32 latency = input_now() - probeTime;
+    Uint32 bucket = latency / 1000;
+    probeHist[bucket < INPUT_PROBE_BUCKETS ? bucket : INPUT_PROBE_BUCKETS - 1]++;
+    probeCount++;
+    probeSum += latency;
+    if (latency > probeMax) probeMax = latency;
+}
+
+// Upper edge of the bucket holding the given share of samples, in ms
+static int percentile(int pct) {
+    unsigned long want = (probeCount * pct + 99) / 100, seen = 0;
+    for (int b = 0; b < INPUT_PROBE_BUCKETS; b++) {
+        seen += probeHist[b];
+        if (seen >= want) return b + 1;
+    }
+    return INPUT_PROBE_BUCKETS;
+}
+
+void input_report(FILE *out) {
+    fprintf(out, "input: %s event thread, %lu events dropped\n",
+            threaded ? "with" : "without", dropped);
+    if (!probeCount) return;
+    fprintf(out, "input: key to flip avg %.1f ms, p50 <%d ms, p95 <%d ms, max %.1f ms over %lu frames\n",
+            probeSum / 1000.0 / probeCount, percentile(50), percentile(95), probeMax / 1000.0, probeCount);
+}
@@ -0,0 +1,39 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <SDL/SDL.h>
+#include <stdio.h>
+
+// Timestamped keyboard input. An event filter stamps each key event as SDL
+// receives it and moves it into a single-producer/single-consumer queue, so
+// the game loop can apply everything that happened before the tick it is
+// simulating, in order, even presses shorter than a frame. With SDL's event
+// thread the filter runs as events arrive instead of when the loop polls.
+//
+// The latency probe measures from the oldest key event a frame applied to
+// the SDL_Flip that showed it.
+
+#define INPUT_QUEUE 256         // power of two
+#define INPUT_PROBE_BUCKETS 64  // 1 ms each, the last one collects the rest
+
+typedef struct {
+    SDL_Event event;
+    Uint32 time;            // µs, same clock as input_now()
+} InputEvent;
+
+// SDL_Init with SDL's event thread where the platform has one
+int    input_sdl_init(Uint32 flags);
+// Key events go to the queue between start and stop, not to SDL_PollEvent
+void   input_start(void);
+void   input_stop(void);
+Uint32 input_now(void);
+// Next key event stamped at or before `until`; 0 if there is none
+int    input_poll(InputEvent *out, Uint32 until);
+
+// The frame being drawn shows the effect of an event stamped `time`
+void   input_probe_mark(Uint32 time);
+// Right after SDL_Flip
+void   input_probe_flip(void);
+void   input_report(FILE *out);
+
+#endif
@@ -0,0 +1,209 @@
+#include "jobs.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#define JOB_MAX_WORKERS 32
+#define JOB_DEQUE_SIZE 256
+
+typedef struct {
+    JobRangeFn fn;
+    void *ctx;
+    int begin, end;
+} Job;
+
+// The owner pushes and pops at the bottom, thieves take from the top.
+typedef struct {
+    Job items[JOB_DEQUE_SIZE];
+    int top, bottom;
+    SDL_mutex *lock;
+} JobDeque;
+
+static JobDeque deques[JOB_MAX_WORKERS];
+static SDL_Thread *threads[JOB_MAX_WORKERS];
+static int workerCount = 0;
+
+static SDL_mutex *poolLock = NULL;
+static SDL_cond *workCond = NULL;
+static SDL_cond *doneCond = NULL;
+static int generation = 0;   // bumped once per parallel_for
+static int pendingJobs = 0;  // pushed but not yet finished
+static int quitting = 0;
+
+static void dequePush(JobDeque *d, Job job) {
+    SDL_mutexP(d->lock);
+    d->items[d->bottom % JOB_DEQUE_SIZE] = job;
+    d->bottom++;
+    SDL_mutexV(d->lock);
+}
+
+static int dequePop(JobDeque *d, Job *out) {
+    int found = 0;
+    SDL_mutexP(d->lock);
+    if (d->bottom > d->top) {
+        d->bottom--;
+        *out = d->items[d->bottom % JOB_DEQUE_SIZE];
+        found = 1;
+    }
+    if (d->bottom == d->top) d->top = d->bottom = 0;
+    SDL_mutexV(d->lock);
+    return found;
+}
+
+static int dequeSteal(JobDeque *d, Job *out) {
+    int found = 0;
+    SDL_mutexP(d->lock);
+    if (d->bottom > d->top) {
+        *out = d->items[d->top % JOB_DEQUE_SIZE];
+        d->top++;
+        found = 1;
+    }
+    if (d->bottom == d->top) d->top = d->bottom = 0;
+    SDL_mutexV(d->lock);
+    return found;
+}
+
+static int findJob(int self, Job *out) {
+    if (dequePop(&deques[self], out)) return 1;
+    for (int k = 1; k < workerCount; k++) {
+        if (dequeSteal(&deques[(self + k) % workerCount], out)) return 1;
+    }
+    return 0;
+}
+
+static void runJob(Job *job) {
+    job->fn(job->ctx, job->begin, job->end);
+    SDL_mutexP(poolLock);
+    pendingJobs--;
+    if (pendingJobs == 0) SDL_CondSignal(doneCond);
+    SDL_mutexV(poolLock);
+}
+
+static int workerMain(void *arg) {
+    int self = (int)(intptr_t)arg;
+    int seen = 0;
+    Job job;
+
+    for (;;) {
+        SDL_mutexP(poolLock);
+        while (!quitting && generation == seen) SDL_CondWait(workCond, poolLock);
+        if (quitting) {
+            SDL_mutexV(poolLock);
+            return 0;
+        }
+        seen = generation;
+        SDL_mutexV(poolLock);
+
+        // Jobs never spawn jobs, so once every deque is empty this
+        // generation is done and the worker can go back to sleep.
+        while (findJob(self, &job)) runJob(&job);
+    }
+}
+
+int jobs_init(int workers) {
+    if (workers <= 0) workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (workers < 1) workers = 1;
+    if (workers > JOB_MAX_WORKERS) workers = JOB_MAX_WORKERS;
+
+    poolLock = SDL_CreateMutex();
+    workCond = SDL_CreateCond();
+    doneCond = SDL_CreateCond();
+    if (!poolLock || !workCond || !doneCond) {
+        printf("Failed to create job pool: %s\n", SDL_GetError());
+        return -1;
+    }
+
+    quitting = 0;
+    workerCount = 1;
+    deques[0].lock = SDL_CreateMutex();
+    for (int i = 1; i < workers; i++) {
+        deques[i].top = deques[i].bottom = 0;
+        deques[i].lock = SDL_CreateMutex();
+        threads[i] = SDL_CreateThread(workerMain, (void *)(intptr_t)i);
+        if (!threads[i]) {
+            printf("Failed to start job worker %d: %s\n", i, SDL_GetError());
+            SDL_DestroyMutex(deques[i].lock);
+            break;
+        }
+        workerCount++;
+    }
+    return 0;
+}
+
+void jobs_shutdown(void) {
+    if (!poolLock) return;
+
+    SDL_mutexP(poolLock);
+    quitting = 1;
+    SDL_CondBroadcast(workCond);
+    SDL_mutexV(poolLock);
+
+    for (int i = 1; i < workerCount; i++) SDL_WaitThread(threads[i], NULL);
+    for (int i = 0; i < workerCount; i++) SDL_DestroyMutex(deques[i].lock);
+
+    SDL_DestroyCond(doneCond);
+    SDL_DestroyCond(workCond);
+    SDL_DestroyMutex(poolLock);
+    poolLock = NULL;
+    workerCount = 0;
+}
+
+int jobs_worker_count(void) {
+    return workerCount;
+}
+
+void jobs_parallel_for(int count, int grain, JobRangeFn fn, void *ctx) {
+    if (count <= 0) return;
+    if (grain < 1) grain = 1;
+
+    // Not worth waking anyone for a single chunk.
+    if (workerCount <= 1 || count <= grain) {
+        fn(ctx, 0, count);
+        return;
+    }
+
+    int chunks = (count + grain - 1) / grain;
+    if (chunks > workerCount * JOB_DEQUE_SIZE) {
+        grain = (count + workerCount * JOB_DEQUE_SIZE - 1) / (workerCount * JOB_DEQUE_SIZE);
+        chunks = (count + grain - 1) / grain;
+    }
+
+    SDL_mutexP(poolLock);
+    pendingJobs += chunks;
+    SDL_mutexV(poolLock);
+
+    for (int c = 0; c < chunks; c++) {
+        Job job = {fn, ctx, c * grain, (c + 1) * grain < count ? (c + 1) * grain : count};
+        dequePush(&deques[c % workerCount], job);
+    }
+
+    SDL_mutexP(poolLock);
+    generation++;
+    SDL_CondBroadcast(workCond);
+    SDL_mutexV(poolLock);
+
+    Job job;
+    while (findJob(0, &job)) runJob(&job);
+
+    SDL_mutexP(poolLock);
+    while (pendingJobs > 0) SDL_CondWait(doneCond, poolLock);
+    SDL_mutexV(poolLock);
+}
+
+Uint32 rng_seed(Uint32 seed, int stream) {
+    // splitmix-style mix so neighbouring streams start far apart
+    Uint32 z = seed + 0x9E3779B9u * (Uint32)(stream + 1);
+    z = (z ^ (z >> 16)) * 0x85EBCA6Bu;
+    z = (z ^ (z >> 13)) * 0xC2B2AE35u;
+    z ^= z >> 16;
+    return z ? z : 0x6D2B79F5u;
+}
+
+int rng_next(Uint32 *state) {
+    Uint32 x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return (int)(x >> 1);
+}
@@ -0,0 +1,25 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <SDL/SDL.h>
+
+// Work-stealing job pool. The calling (main) thread is worker 0 and takes
+// part in every parallel_for, so a pool of 1 simply runs everything inline.
+
+typedef void (*JobRangeFn)(void *ctx, int begin, int end);
+
+// workers <= 0 uses one worker per online CPU.
+int  jobs_init(int workers);
+void jobs_shutdown(void);
+int  jobs_worker_count(void);
+
+// Splits [0, count) into chunks of at most `grain` items, spreads them over
+// the worker deques and returns once every chunk has run.
+void jobs_parallel_for(int count, int grain, JobRangeFn fn, void *ctx);
+
+// Per-entity RNG streams: each entity owns its state, so the sequence it sees
+// does not depend on which worker ran it or in which order.
+Uint32 rng_seed(Uint32 seed, int stream);
+int    rng_next(Uint32 *state);
+
+#endif
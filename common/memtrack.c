@@ -0,0 +1,154 @@
+#define MEMTRACK_IMPL
+#include "memtrack.h"
+#include <string.h>
+
+// Without -DMEMTRACK the header compiles the tracker out
+#ifdef MEMTRACK
+
+#define MEMTRACK_MAX 2048
+#define MEMTRACK_NAME 40
+#define MEMTRACK_CATEGORIES 32
+#define MEMTRACK_SHOWN 10         // steady-state allocations printed per run
+
+typedef struct {
+    SDL_Surface *surf;
+    const char *category;
+    const char *file;
+    int line;
+    char name[MEMTRACK_NAME];
+    size_t bytes;
+    unsigned long frame;          // frame it was allocated in
+} TrackedSurface;
+
+// Live surfaces in allocation order; frees swap the last one in
+static TrackedSurface live[MEMTRACK_MAX];
+static int liveCount = 0;
+static int overflow = 0;          // allocations the table had no room for
+
+static const char *currentCategory = NULL;
+static unsigned long frame = 0;
+static unsigned long settledAt = 0;
+static int frameAllocs = 0;
+static int worstFrameAllocs = 0;  // most allocations in one steady-state frame
+static unsigned long steadyAllocs = 0;
+static unsigned long allocs = 0, frees = 0, untrackedFrees = 0;
+static size_t liveBytes = 0, peakBytes = 0;
+
+static size_t surfaceBytes(const SDL_Surface *s) {
+    size_t bytes = sizeof(SDL_Surface) + sizeof(SDL_PixelFormat) + (size_t)s->pitch * s->h;
+    if (s->format->palette) bytes += s->format->palette->ncolors * sizeof(SDL_Color);
+    return bytes;
+}
+
+// Paths keep only their tail, which is what tells assets apart
+static void copyName(char *dst, const char *name) {
+    size_t n = strlen(name);
+    if (n >= MEMTRACK_NAME) name += n - (MEMTRACK_NAME - 1);
+    strcpy(dst, name);
+}
+
+SDL_Surface *memtrack_add(SDL_Surface *s, const char *kind, const char *name, const char *file, int line) {
+    if (!s) return NULL;
+
+    allocs++;
+    frameAllocs++;
+    if (frame - settledAt >= MEMTRACK_WARMUP) {
+        if (steadyAllocs < MEMTRACK_SHOWN) {
+            printf("memtrack: frame %lu allocates %dx%d %s at %s:%d\n",
+                   frame, s->w, s->h, name ? name : kind, file, line);
+        }
+        steadyAllocs++;
+    }
+
+    if (liveCount == MEMTRACK_MAX) {
+        overflow++;
+        return s;
+    }
+    TrackedSurface *t = &live[liveCount++];
+    t->surf = s;
+    t->category = currentCategory ? currentCategory : kind;
+    t->file = file;
+    t->line = line;
+    t->name[0] = '\0';
+    if (name) copyName(t->name, name);
+    t->bytes = surfaceBytes(s);
+    t->frame = frame;
+
+    liveBytes += t->bytes;
+    if (liveBytes > peakBytes) peakBytes = liveBytes;
+    return s;
+}
+
+void memtrack_free(SDL_Surface *s, const char *file, int line) {
+    if (!s) return;
+
+    // Only the last reference actually releases the pixels
+    if (s->refcount <= 1) {
+        int i = liveCount - 1;
+        while (i >= 0 && live[i].surf != s) i--;
+        if (i >= 0) {
+            liveBytes -= live[i].bytes;
+            live[i] = live[--liveCount];
+            frees++;
+        } else {
+            // The screen, or a surface made before tracking could see it
+            untrackedFrees++;
+        }
+    }
+    (void)file;
+    (void)line;
+    SDL_FreeSurface(s);
+}
+
+void memtrack_category(const char *category) {
+    currentCategory = category;
+}
+
+void memtrack_frame(void) {
+    if (frame - settledAt >= MEMTRACK_WARMUP && frameAllocs > worstFrameAllocs) worstFrameAllocs = frameAllocs;
+    frame++;
+    frameAllocs = 0;
+}
+
+void memtrack_settle(void) {
+    settledAt = frame;
+}
+
+int memtrack_finish(FILE *out) {
+    const char *names[MEMTRACK_CATEGORIES];
+    size_t bytes[MEMTRACK_CATEGORIES];
+    int counts[MEMTRACK_CATEGORIES];
+    int categories = 0;
+
+    for (int i = 0; i < liveCount; i++) {
+        int c = 0;
+        while (c < categories && strcmp(names[c], live[i].category) != 0) c++;
+        if (c == categories) {
+            if (categories == MEMTRACK_CATEGORIES) continue;
+            names[c] = live[i].category;
+            bytes[c] = 0;
+            counts[c] = 0;
+            categories++;
+        }
+        bytes[c] += live[i].bytes;
+        counts[c]++;
+    }
+
+    fprintf(out, "Surfaces: %lu allocated, %lu freed, %lu untracked frees, peak %lu bytes over %lu frames\n",
+            allocs, frees, untrackedFrees, (unsigned long)peakBytes, frame);
+    for (int c = 0; c < categories; c++) {
+        fprintf(out, "  %-16s %4d live, %lu bytes\n", names[c], counts[c], (unsigned long)bytes[c]);
+    }
+    for (int i = 0; i < liveCount; i++) {
+        fprintf(out, "  leak: %dx%d %s (%s) from %s:%d, frame %lu\n", live[i].surf->w, live[i].surf->h,
+                live[i].name[0] ? live[i].name : "-", live[i].category, live[i].file, live[i].line, live[i].frame);
+    }
+    if (overflow) fprintf(out, "  %d allocations were not tracked, the table is full\n", overflow);
+    if (steadyAllocs) {
+        fprintf(out, "  %lu allocations in steady-state frames, up to %d in one frame\n", steadyAllocs, worstFrameAllocs);
+    }
+
+    return liveCount > 0 || steadyAllocs > 0 || overflow > 0;
+}
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef MEMTRACK_H
+#define MEMTRACK_H
+
+#include <SDL/SDL.h>
+#include <stdio.h>
+
+// Surface lifetime tracker, built in with -DMEMTRACK (make MEMTRACK=1) and
+// compiled out otherwise. Include it after the SDL headers: it wraps surface
+// creation, loading and freeing so every live surface is known with its call
+// site, asset name, category and size.
+//
+// A run fails when a steady-state frame allocates a surface, or when surfaces
+// are still alive at memtrack_finish(). Frames count as steady state once
+// MEMTRACK_WARMUP frames have passed since the start or the last
+// memtrack_settle().
+
+#define MEMTRACK_WARMUP 60
+
+#ifdef MEMTRACK
+
+SDL_Surface *memtrack_add(SDL_Surface *s, const char *kind, const char *name, const char *file, int line);
+void memtrack_free(SDL_Surface *s, const char *file, int line);
+// Category for the surfaces allocated from now on; NULL goes back to the
+// allocation kind ("image", "created", "converted", "text")
+void memtrack_category(const char *category);
+void memtrack_frame(void);
+void memtrack_settle(void);
+// Reports live bytes per category and any leaks; non-zero when the run failed
+int  memtrack_finish(FILE *out);
+
+#ifndef MEMTRACK_IMPL
+#define SDL_CreateRGBSurface(...) memtrack_add(SDL_CreateRGBSurface(__VA_ARGS__), "created", NULL, __FILE__, __LINE__)
+#define SDL_CreateRGBSurfaceFrom(...) memtrack_add(SDL_CreateRGBSurfaceFrom(__VA_ARGS__), "created", NULL, __FILE__, __LINE__)
+#define SDL_ConvertSurface(...) memtrack_add(SDL_ConvertSurface(__VA_ARGS__), "converted", NULL, __FILE__, __LINE__)
+#define SDL_DisplayFormat(s) memtrack_add(SDL_DisplayFormat(s), "converted", NULL, __FILE__, __LINE__)
+#define SDL_DisplayFormatAlpha(s) memtrack_add(SDL_DisplayFormatAlpha(s), "converted", NULL, __FILE__, __LINE__)
+#define IMG_Load(path) memtrack_add(IMG_Load(path), "image", (path), __FILE__, __LINE__)
+#define TTF_RenderText_Solid(f, t, c) memtrack_add(TTF_RenderText_Solid(f, t, c), "text", (t), __FILE__, __LINE__)
+#define TTF_RenderText_Blended(f, t, c) memtrack_add(TTF_RenderText_Blended(f, t, c), "text", (t), __FILE__, __LINE__)
+#define SDL_FreeSurface(s) memtrack_free((s), __FILE__, __LINE__)
+#endif
+
+#else
+
+#define memtrack_category(category) ((void)0)
+#define memtrack_frame() ((void)0)
+#define memtrack_settle() ((void)0)
+#define memtrack_finish(out) 0
+
+#endif
+
+#endif
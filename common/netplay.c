@@ -0,0 +1,341 @@
+#include "netplay.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+
+#define NET_HELLO 'H'
+#define NET_INPUTS 'I'
+#define NET_BYE 'B'
+#define NET_MAX_RUNS 32
+#define NET_PACKET_MAX (18 + 2 * NET_MAX_RUNS)
+
+static Uint32 netNow(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (Uint32)(ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
+
+// Frame numbers wrap like SDL ticks do
+static bool before(Uint32 a, Uint32 b) {
+    return (Sint32)(a - b) < 0;
+}
+
+static void putU32(Uint8 *p, Uint32 v) {
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+static Uint32 getU32(const Uint8 *p) {
+    return p[0] | p[1] << 8 | p[2] << 16 | (Uint32)p[3] << 24;
+}
+
+static void sendPacket(NetPlay *np, const Uint8 *data, int len) {
+    if (sendto(np->sock, data, len, 0, (struct sockaddr *)&np->peer, sizeof(np->peer)) == len) {
+        np->packetsOut++;
+        np->bytesOut += len;
+    }
+}
+
+// type, player, has yours, delay, seed
+static void sendHello(NetPlay *np, bool gotPeer) {
+    Uint8 p[8] = {NET_HELLO, np->local, gotPeer, np->delay};
+    putU32(p + 4, np->seed);
+    sendPacket(np, p, sizeof(p));
+}
+
+// Newest frame whose state both sides can agree on: both inputs known and
+// nothing pending replay
+static Uint32 settledEnd(const NetPlay *np) {
+    Uint32 end = np->frame;
+    if (before(np->remoteNext, end)) end = np->remoteNext;
+    if (before(np->redoFrom, end)) end = np->redoFrom;
+    return end;
+}
+
+// type, runs, first frame, ack, checked frame, checksum, then (length, input) runs
+static void sendInputs(NetPlay *np) {
+    Uint8 p[NET_PACKET_MAX];
+    Uint32 first = np->peerHas;
+    if (np->localNext - first > NET_WINDOW) first = np->localNext - NET_WINDOW;
+    int runs = 0;
+    Uint8 *r = p + 18;
+    for (Uint32 f = first; before(f, np->localNext) && runs < NET_MAX_RUNS; f++) {
+        Uint8 v = np->inputs[f % NET_WINDOW][np->local];
+        if (runs && r[-1] == v && r[-2] < 255) {
+            r[-2]++;
+        } else {
+            r[0] = 1;
+            r[1] = v;
+            r += 2;
+            runs++;
+        }
+    }
+    Uint32 checked = settledEnd(np) - 1;
+    p[0] = NET_INPUTS;
+    p[1] = runs;
+    putU32(p + 2, first);
+    putU32(p + 6, np->remoteNext);
+    putU32(p + 10, checked);
+    putU32(p + 14, np->checkFrame[checked % NET_WINDOW] == checked ? np->check[checked % NET_WINDOW] : 0);
+    sendPacket(np, p, r - p);
+}
+
+static void takeInputs(NetPlay *np, const Uint8 *p, int len) {
+    int runs = p[1];
+    if (len < 18 + 2 * runs) return;
+    Uint32 first = getU32(p + 2), ack = getU32(p + 6);
+    if (before(np->peerHas, ack)) np->peerHas = ack;
+    if (!np->snapshots) return;
+
+    // Only extend the confirmed run; a gap waits for the next packet, which
+    // repeats everything unacknowledged
+    Uint32 f = first;
+    for (int i = 0; i < runs && !before(np->remoteNext, f); i++) {
+        for (int k = 0; k < p[18 + 2 * i]; k++, f++) {
+            if (before(f, np->remoteNext)) continue;
+            if (!before(f, np->frame) && f - np->frame >= NET_WINDOW / 2) return;
+            Uint8 v = p[19 + 2 * i];
+            if (before(f, np->frame) && np->guessed[f % NET_WINDOW] != v && before(f, np->redoFrom)) np->redoFrom = f;
+            np->inputs[f % NET_WINDOW][np->remote] = v;
+            np->remoteNext = f + 1;
+        }
+    }
+
+    // Compare the peer's checksum once this side has settled the same frame
+    Uint32 checked = getU32(p + 10), sum = getU32(p + 14);
+    if (checked != (Uint32)-1 && np->checkFrame[checked % NET_WINDOW] == checked && before(checked, settledEnd(np)) &&
+        !before(checked, np->comparedTo)) {
+        np->checksCompared++;
+        if (np->check[checked % NET_WINDOW] != sum) {
+            if (!np->desyncs) printf("netplay: desync at frame %u\n", checked);
+            np->desyncs++;
+        }
+        np->comparedTo = checked + 1;
+    }
+}
+
+static void receive(NetPlay *np) {
+    Uint8 p[NET_PACKET_MAX];
+    struct sockaddr_in from;
+    socklen_t fromLen = sizeof(from);
+    int len;
+    while ((len = recvfrom(np->sock, p, sizeof(p), 0, (struct sockaddr *)&from, &fromLen)) > 0) {
+        fromLen = sizeof(from);
+        if (from.sin_port != np->peer.sin_port || from.sin_addr.s_addr != np->peer.sin_addr.s_addr) continue;
+        np->packetsIn++;
+        np->bytesIn += len;
+        np->lastHeard = SDL_GetTicks();
+        if (p[0] == NET_HELLO && len >= 8) {
+            np->remoteDelay = p[3];
+            if (np->local == 1) np->seed = getU32(p + 4);
+            if (p[2]) np->connected = true;
+            else sendHello(np, true);
+        } else if (p[0] == NET_INPUTS && len >= 18) {
+            np->connected = true;
+            takeInputs(np, p, len);
+        } else if (p[0] == NET_BYE) {
+            np->peerGone = true;
+        }
+    }
+}
+
+static int bindPort(int sock, int port) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    return bind(sock, (struct sockaddr *)&addr, sizeof(addr));
+}
+
+int netplay_open(NetPlay *np, const char *peerHost, int player, int delay, int rollback, Uint32 seed) {
+    memset(np, 0, sizeof(*np));
+    np->sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (np->sock < 0) {
+        printf("netplay: no socket: %s\n", strerror(errno));
+        return -1;
+    }
+    if (player < -1 || player >= NET_PLAYERS) {
+        printf("netplay: no player %d, only 1 or 2\n", player + 1);
+        close(np->sock);
+        return -1;
+    }
+    if (player < 0) {
+        player = bindPort(np->sock, NET_PORT) == 0 ? 0 : 1;
+        if (player == 1 && bindPort(np->sock, NET_PORT + 1) != 0) player = -1;
+    } else if (bindPort(np->sock, NET_PORT + player) != 0) {
+        player = -1;
+    }
+    if (player < 0) {
+        printf("netplay: cannot bind port %d or %d: %s\n", NET_PORT, NET_PORT + 1, strerror(errno));
+        close(np->sock);
+        return -1;
+    }
+    fcntl(np->sock, F_SETFL, fcntl(np->sock, F_GETFL) | O_NONBLOCK);
+
+    struct addrinfo hints, *found = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    if (getaddrinfo(peerHost, NULL, &hints, &found) != 0 || !found) {
+        printf("netplay: unknown host %s\n", peerHost);
+        close(np->sock);
+        return -1;
+    }
+    memcpy(&np->peer, found->ai_addr, sizeof(np->peer));
+    freeaddrinfo(found);
+
+    np->local = player;
+    np->remote = 1 - player;
+    np->peer.sin_port = htons(NET_PORT + np->remote);
+    np->delay = delay < 0 ? 0 : delay > 8 ? 8 : delay;
+    np->rollback = rollback < 0 ? 0 : rollback > NET_MAX_ROLLBACK ? NET_MAX_ROLLBACK : rollback;
+    np->seed = seed;
+    return 0;
+}
+
+int netplay_connect(NetPlay *np, Uint32 timeoutMs) {
+    Uint32 start = SDL_GetTicks(), lastHello = 0;
+    printf("netplay: player %d waiting for the peer on port %d\n", np->local + 1, NET_PORT + np->remote);
+    while (!np->connected && !np->peerGone) {
+        Uint32 now = SDL_GetTicks();
+        if (now - start >= timeoutMs) {
+            printf("netplay: no answer from the peer\n");
+            return -1;
+        }
+        if (!lastHello || now - lastHello >= 100) {
+            sendHello(np, np->packetsIn > 0);
+            lastHello = now;
+        }
+        receive(np);
+
+        // The window is already up: let it be closed, or Escape give up waiting
+        SDL_Event event;
+        while (SDL_PollEvent(&event)) {
+            bool quit = event.type == SDL_QUIT;
+            if (quit || (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_ESCAPE)) {
+                printf("netplay: stopped waiting for the peer\n");
+                // Closing the window still closes the game once it is running
+                if (quit) SDL_PushEvent(&event);
+                return -1;
+            }
+        }
+        SDL_Delay(5);
+    }
+    return np->connected ? 0 : -1;
+}
+
+int netplay_start(NetPlay *np, const NetGame *game) {
+    np->game = *game;
+    np->snapshots = malloc(game->stateSize * NET_WINDOW);
+    if (!np->snapshots) return -1;
+    for (int i = 0; i < NET_WINDOW; i++) np->checkFrame[i] = (Uint32)-1;
+    // Both sides agree the first `delay` frames of each player are blank
+    np->localNext = np->delay;
+    np->peerHas = np->delay;
+    np->remoteNext = np->remoteDelay;
+    np->frame = np->redoFrom = 0;
+    np->startTicks = np->lastHeard = SDL_GetTicks();
+    return 0;
+}
+
+void netplay_close(NetPlay *np) {
+    if (np->sock >= 0 && np->connected && !np->peerGone) {
+        Uint8 bye = NET_BYE;
+        for (int i = 0; i < 3; i++) sendPacket(np, &bye, 1);
+    }
+    if (np->sock >= 0) close(np->sock);
+    np->sock = -1;
+    free(np->snapshots);
+    np->snapshots = NULL;
+}
+
+void netplay_poll(NetPlay *np) {
+    receive(np);
+    if (SDL_GetTicks() - np->lastHeard > NET_TIMEOUT_MS) np->peerGone = true;
+}
+
+bool netplay_push(NetPlay *np, Uint8 input) {
+    bool taken = !before(np->frame + np->delay, np->localNext);
+    if (taken) {
+        np->inputs[np->localNext % NET_WINDOW][np->local] = input;
+        np->localNext++;
+    }
+    // Plain lockstep waits on every frame, so it cannot wait for a batch
+    int every = np->rollback ? NET_SEND_EVERY : 1;
+    if ((taken && input != np->lastSent) || ++np->sinceSend >= every) {
+        sendInputs(np);
+        np->lastSent = input;
+        np->sinceSend = 0;
+    }
+    return taken;
+}
+
+static void runFrame(NetPlay *np, Uint32 f) {
+    int slot = f % NET_WINDOW;
+    memcpy(np->snapshots + slot * np->game.stateSize, np->game.state, np->game.stateSize);
+    // The peer most likely still holds what it last sent
+    Uint8 guess = np->inputs[(np->remoteNext - 1) % NET_WINDOW][np->remote];
+    if (np->remoteNext == 0) guess = 0;
+    Uint8 in[NET_PLAYERS];
+    in[np->local] = np->inputs[slot][np->local];
+    in[np->remote] = before(f, np->remoteNext) ? np->inputs[slot][np->remote] : guess;
+    np->guessed[slot] = in[np->remote];
+    np->game.step(np->game.user, in);
+    np->checkFrame[slot] = f;
+    np->check[slot] = np->game.checksum(np->game.user);
+}
+
+int netplay_advance(NetPlay *np) {
+    if (np->peerGone || !np->snapshots) return 0;
+
+    if (before(np->redoFrom, np->frame)) {
+        Uint32 t0 = netNow();
+        Uint32 redo = np->frame - np->redoFrom;
+        memcpy(np->game.state, np->snapshots + (np->redoFrom % NET_WINDOW) * np->game.stateSize, np->game.stateSize);
+        for (Uint32 f = np->redoFrom; before(f, np->frame); f++) runFrame(np, f);
+        Uint32 spent = netNow() - t0;
+        np->rollbacks++;
+        np->framesRedone += redo;
+        if (redo > np->maxRedo) np->maxRedo = redo;
+        np->redoUs += spent;
+        if (spent > np->maxRedoUs) np->maxRedoUs = spent;
+        np->redoFrom = np->frame;
+    }
+
+    Uint32 f = np->frame;
+    bool haveLocal = before(f, np->localNext);
+    bool haveRemote = before(f, np->remoteNext) || f - np->remoteNext < (Uint32)np->rollback;
+    if (!haveLocal || !haveRemote) {
+        np->stalls++;
+        return 0;
+    }
+    Uint32 t0 = netNow();
+    runFrame(np, f);
+    np->stepUs += netNow() - t0;
+    np->frame = np->redoFrom = f + 1;
+    np->framesRun++;
+    return 1;
+}
+
+void netplay_report(const NetPlay *np, FILE *out) {
+    double seconds = (SDL_GetTicks() - np->startTicks) / 1000.0;
+    if (!np->framesRun || seconds <= 0) return;
+    fprintf(out, "netplay: player %d, delay %d, rollback %d, %lu frames in %.1f s, %lu stalls\n",
+            np->local + 1, np->delay, np->rollback, np->framesRun, seconds, np->stalls);
+    fprintf(out, "netplay: out %.0f B/s (%.0f on the wire, %.1f packets/s), in %.0f B/s, %.1f B per frame\n",
+            np->bytesOut / seconds, (np->bytesOut + np->packetsOut * NET_UDP_OVERHEAD) / seconds,
+            np->packetsOut / seconds, np->bytesIn / seconds, (double)np->bytesOut / np->framesRun);
+    fprintf(out, "netplay: step %.1f us avg; %lu rollbacks, %lu frames replayed (max %lu), %.1f us avg, %u us max\n",
+            (double)np->stepUs / np->framesRun, np->rollbacks, np->framesRedone, np->maxRedo,
+            np->rollbacks ? (double)np->redoUs / np->rollbacks : 0.0, np->maxRedoUs);
+    fprintf(out, "netplay: %lu checksums compared, %lu desyncs\n", np->checksCompared, np->desyncs);
+}
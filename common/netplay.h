@@ -0,0 +1,101 @@
+#ifndef NETPLAY_H
+#define NETPLAY_H
+
+#include <SDL/SDL.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <netinet/in.h>
+
+// Two-player lockstep over UDP. Only inputs cross the wire, one byte per
+// player per frame; both sides run the same deterministic fixed-step game
+// from the same seed, so the same inputs give the same states.
+//
+// Local input is scheduled `delay` frames ahead. Every packet repeats all of
+// the local inputs the peer has not acknowledged yet, run-length encoded, so
+// a lost packet is healed by the next one and a held key costs two bytes
+// however long it is held. With `rollback` > 0 the game may run up to that
+// many frames past the last remote input it has, guessing that the peer kept
+// its keys as they were; a wrong guess restores the snapshot of the first
+// wrong frame and plays forward again. With 0 it waits for the peer, as
+// plain lockstep.
+//
+// Each packet also carries the checksum of the newest state both inputs are
+// known for, so a desync is noticed where it happens.
+
+#define NET_PLAYERS 2
+#define NET_WINDOW 64           // frames of inputs, snapshots and checksums kept
+#define NET_MAX_ROLLBACK 12
+#define NET_SEND_EVERY 4        // frames between packets while the keys do not change
+#define NET_PORT 7000           // player 0 binds this, player 1 the next one
+#define NET_TIMEOUT_MS 5000     // peer silence that ends the session
+#define NET_UDP_OVERHEAD 28     // IPv4 + UDP headers, for the on-wire figures
+
+// The game being played. `state` is copied whole for snapshots, so it must
+// not hold pointers into itself or to anything a step changes.
+typedef struct {
+    void *state;
+    size_t stateSize;
+    void *user;
+    void (*step)(void *user, const Uint8 *inputs);  // one frame, NET_PLAYERS inputs
+    Uint32 (*checksum)(void *user);
+} NetGame;
+
+typedef struct {
+    int sock;
+    struct sockaddr_in peer;
+    int local, remote;          // player slots
+    int delay, rollback;
+    int remoteDelay;            // the peer's first frames are blank up to this
+    Uint32 seed;                // player 0's, once connected
+    bool connected, peerGone;
+
+    NetGame game;
+    Uint8 *snapshots;           // state before each frame, NET_WINDOW of them
+    Uint8 inputs[NET_WINDOW][NET_PLAYERS];
+    Uint8 guessed[NET_WINDOW];  // remote input each frame was last simulated with
+    Uint32 checkFrame[NET_WINDOW];
+    Uint32 check[NET_WINDOW];
+
+    Uint32 frame;               // next frame to simulate
+    Uint32 localNext;           // local inputs are set for frames below this
+    Uint32 remoteNext;          // remote inputs are confirmed for frames below this
+    Uint32 peerHas;             // the peer has our inputs for frames below this
+    Uint32 redoFrom;            // first frame simulated with a wrong guess; == frame when none
+    int sinceSend;
+    Uint8 lastSent;
+    Uint32 lastHeard;           // SDL ticks
+    Uint32 comparedTo;          // newest frame whose checksum was compared, + 1
+
+    // Instrumentation
+    Uint32 startTicks;
+    unsigned long packetsOut, packetsIn, bytesOut, bytesIn;
+    unsigned long framesRun, stalls;
+    unsigned long rollbacks, framesRedone, maxRedo;
+    Uint64 redoUs, stepUs;
+    Uint32 maxRedoUs;
+    unsigned long checksCompared, desyncs;
+} NetPlay;
+
+// Binds the local port and aims at the peer. `player` is 0 or 1, or -1 to
+// take slot 0 if NET_PORT is free and slot 1 otherwise, which is what two
+// processes on one machine want.
+int  netplay_open(NetPlay *np, const char *peerHost, int player, int delay, int rollback, Uint32 seed);
+// Exchanges hellos until the peer answers; np->seed is then player 0's.
+// Closing the window or pressing Escape gives up, and a close is left queued
+// for the game loop.
+int  netplay_connect(NetPlay *np, Uint32 timeoutMs);
+// Takes the game once its state is built from np->seed
+int  netplay_start(NetPlay *np, const NetGame *game);
+void netplay_close(NetPlay *np);
+
+// Once per fixed step: receive, offer this step's local input (false when
+// the input queue is full and it was not taken), then advance. Advancing
+// replays any mispredicted frames and runs at most one new frame; 0 means
+// it had to wait for the peer.
+void netplay_poll(NetPlay *np);
+bool netplay_push(NetPlay *np, Uint8 input);
+int  netplay_advance(NetPlay *np);
+
+void netplay_report(const NetPlay *np, FILE *out);
+
+#endif
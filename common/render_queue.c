@@ -0,0 +1,201 @@
+#include "render_queue.h"
+#include "memtrack.h"
+#include "world.h"
+#include <stdlib.h>
+#include <stdint.h>
+
+void rq_init(RenderQueue *rq) {
+    RenderQueue empty = {0};
+    *rq = empty;
+    rq->scalePct = 100;
+}
+
+static void dropScaled(RenderQueue *rq) {
+    for (int i = 0; i < rq->scaledCount; i++) {
+        if (rq->scaled[i].scaled) SDL_FreeSurface(rq->scaled[i].scaled);
+    }
+    rq->scaledCount = 0;
+}
+
+void rq_free(RenderQueue *rq) {
+    free(rq->items);
+    rq->items = NULL;
+    rq->count = rq->capacity = 0;
+    dropScaled(rq);
+    free(rq->scaled);
+    rq->scaled = NULL;
+    rq->scaledCapacity = 0;
+}
+
+void rq_set_mark(RenderQueue *rq, void (*mark)(void *user, const SDL_Rect *r), void *user) {
+    rq->mark = mark;
+    rq->markUser = user;
+}
+
+void rq_set_scale(RenderQueue *rq, int pct) {
+    pct = pct < 1 ? 1 : pct > 100 ? 100 : pct;
+    if (pct != rq->scalePct) dropScaled(rq);
+    rq->scalePct = pct;
+}
+
+void rq_begin(RenderQueue *rq, int cameraX, int cameraY, int viewW, int viewH) {
+    rq->count = 0;
+    rq->drawn = rq->culled = 0;
+    rq->cameraX = cameraX;
+    rq->cameraY = cameraY;
+    rq->viewW = viewW;
+    rq->viewH = viewH;
+}
+
+static void push(RenderQueue *rq, RenderItem *item) {
+    if (item->x + item->w <= rq->cameraX || item->x >= rq->cameraX + rq->viewW ||
+        item->y + item->h <= rq->cameraY || item->y >= rq->cameraY + rq->viewH) {
+        rq->culled++;
+        return;
+    }
+    if (rq->count == rq->capacity) {
+        // Grows to the busiest frame seen, then stays put
+        int capacity = rq->capacity ? rq->capacity * 2 : 64;
+        RenderItem *items = realloc(rq->items, capacity * sizeof(RenderItem));
+        if (!items) {
+            rq->culled++;
+            return;
+        }
+        rq->items = items;
+        rq->capacity = capacity;
+    }
+    item->order = rq->count;
+    rq->items[rq->count++] = *item;
+}
+
+void rq_blit(RenderQueue *rq, int layer, SDL_Surface *src, const SDL_Rect *srcRect, int x, int y) {
+    rq_blit_tagged(rq, layer, src, srcRect, x, y, 0);
+}
+
+void rq_blit_tagged(RenderQueue *rq, int layer, SDL_Surface *src, const SDL_Rect *srcRect, int x, int y, Uint32 tag) {
+    RenderItem item = {0};
+    item.src = src;
+    item.tag = tag;
+    item.layer = layer;
+    item.x = x;
+    item.y = y;
+    if (srcRect) {
+        item.srcRect = *srcRect;
+        item.hasSrcRect = 1;
+        item.w = srcRect->w;
+        item.h = srcRect->h;
+    } else {
+        item.w = src->w;
+        item.h = src->h;
+    }
+    push(rq, &item);
+}
+
+void rq_fill(RenderQueue *rq, int layer, int x, int y, int w, int h, Uint32 color) {
+    RenderItem item = {0};
+    item.layer = layer;
+    item.x = x;
+    item.y = y;
+    item.w = w;
+    item.h = h;
+    item.color = color;
+    push(rq, &item);
+}
+
+static int compareItems(const void *a, const void *b) {
+    const RenderItem *ia = a, *ib = b;
+    if (ia->layer != ib->layer) return ia->layer - ib->layer;
+    if (ia->src != ib->src) return (uintptr_t)ia->src < (uintptr_t)ib->src ? -1 : 1;
+    return ia->order - ib->order;
+}
+
+// Scales a screen rect by edges rather than by size, so neighbouring items
+// still meet without gaps after rounding
+static SDL_Rect scaleRect(SDL_Rect r, int pct) {
+    int x0 = r.x * pct / 100, y0 = r.y * pct / 100;
+    int x1 = (r.x + r.w) * pct / 100, y1 = (r.y + r.h) * pct / 100;
+    SDL_Rect s = {x0, y0, x1 - x0, y1 - y0};
+    return s;
+}
+
+// The item's picture at the current scale, stretched the first time it is
+// asked for. The copy takes on the sprite's format and blending.
+static SDL_Surface *scaledCopy(RenderQueue *rq, const RenderItem *item) {
+    SDL_Surface *src = item->src;
+    SDL_Rect from = {0, 0, src->w, src->h};
+    if (item->hasSrcRect) from = item->srcRect;
+
+    for (int i = 0; i < rq->scaledCount; i++) {
+        RenderScaled *c = &rq->scaled[i];
+        if (c->src == src && c->tag == item->tag && c->srcRect.x == from.x && c->srcRect.y == from.y &&
+            c->srcRect.w == from.w && c->srcRect.h == from.h) {
+            return c->scaled;
+        }
+    }
+
+    if (rq->scaledCount == rq->scaledCapacity) {
+        int capacity = rq->scaledCapacity ? rq->scaledCapacity * 2 : 32;
+        RenderScaled *grown = realloc(rq->scaled, capacity * sizeof(RenderScaled));
+        if (!grown) return NULL;
+        rq->scaled = grown;
+        rq->scaledCapacity = capacity;
+    }
+
+    SDL_PixelFormat *f = src->format;
+    int w = from.w * rq->scalePct / 100, h = from.h * rq->scalePct / 100;
+    SDL_Surface *s = NULL;
+    if (w > 0 && h > 0) {
+        s = SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, f->BitsPerPixel, f->Rmask, f->Gmask, f->Bmask, f->Amask);
+    }
+    if (s) {
+        SDL_SoftStretch(src, &from, s, NULL);
+        SDL_SetAlpha(s, src->flags & SDL_SRCALPHA, f->alpha);
+        SDL_SetColorKey(s, src->flags & SDL_SRCCOLORKEY, f->colorkey);
+        rq->scaledBuilt++;
+    }
+    RenderScaled *c = &rq->scaled[rq->scaledCount++];
+    c->src = src;
+    c->srcRect = from;
+    c->tag = item->tag;
+    c->scaled = s;
+    return s;
+}
+
+void rq_flush(RenderQueue *rq, SDL_Surface *screen) {
+    qsort(rq->items, rq->count, sizeof(RenderItem), compareItems);
+
+    for (int i = 0; i < rq->count; i++) {
+        RenderItem *item = &rq->items[i];
+        WorldRect r = {item->x, item->y, item->w, item->h};
+        SDL_Rect dst = world_to_screen(r, rq->cameraX, rq->cameraY);
+        if (rq->scalePct < 100 && item->src) {
+            SDL_Surface *s = scaledCopy(rq, item);
+            dst = scaleRect(dst, rq->scalePct);
+            if (!s) continue;
+            dst.w = s->w;
+            dst.h = s->h;
+            SDL_BlitSurface(s, NULL, screen, &dst);
+        } else if (rq->scalePct < 100) {
+            dst = scaleRect(dst, rq->scalePct);
+            SDL_FillRect(screen, &dst, item->color);
+        } else if (item->src) {
+            SDL_BlitSurface(item->src, item->hasSrcRect ? &item->srcRect : NULL, screen, &dst);
+        } else {
+            SDL_FillRect(screen, &dst, item->color);
+        }
+        if (rq->mark) rq->mark(rq->markUser, &dst);
+    }
+
+    rq->drawn = rq->count;
+    rq->totalDrawn += rq->drawn;
+    rq->totalCulled += rq->culled;
+    rq->frames++;
+    rq->count = 0;
+}
+
+void rq_report(const RenderQueue *rq, FILE *out) {
+    if (!rq->frames) return;
+    fprintf(out, "render queue: %lu frames, %lu drawn, %lu culled (%.1f drawn / %.1f culled per frame), %lu scaled copies built\n",
+            rq->frames, rq->totalDrawn, rq->totalCulled,
+            (double)rq->totalDrawn / rq->frames, (double)rq->totalCulled / rq->frames, rq->scaledBuilt);
+}
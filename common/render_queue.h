@@ -0,0 +1,63 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <SDL/SDL.h>
+#include <stdio.h>
+
+// World-space draw list. Items outside the camera are culled on submit; the
+// rest are sorted by layer, then by source surface, and drawn on flush.
+//
+// Below 100% scale each sprite is drawn from a scaled copy made the first
+// time it is seen at that scale and kept until the scale changes. Copies are
+// keyed by surface, source rect and tag, so a surface whose pixels change in
+// place must be submitted with a tag that changes with them.
+
+typedef struct {
+    SDL_Surface *src;      // NULL: solid fill with `color`
+    SDL_Rect srcRect;
+    int hasSrcRect;
+    Uint32 tag;            // which contents `src` holds, for the scaled copies
+    int x, y, w, h;        // world-space destination
+    Uint32 color;
+    int layer;
+    int order;             // submission order, keeps the sort stable
+} RenderItem;
+
+typedef struct {
+    SDL_Surface *src;
+    SDL_Rect srcRect;
+    Uint32 tag;
+    SDL_Surface *scaled;   // NULL: could not be built, the item is skipped
+} RenderScaled;
+
+typedef struct {
+    RenderItem *items;
+    int count, capacity;
+    int cameraX, cameraY, viewW, viewH;
+    int drawn, culled;                  // last flush
+    unsigned long totalDrawn, totalCulled;
+    unsigned long frames;
+    void (*mark)(void *user, const SDL_Rect *r);   // told about every drawn rect
+    void *markUser;
+    int scalePct;                       // target resolution, % of the view
+    RenderScaled *scaled;               // copies at scalePct, when below 100
+    int scaledCount, scaledCapacity;
+    unsigned long scaledBuilt;
+} RenderQueue;
+
+void rq_init(RenderQueue *rq);
+void rq_free(RenderQueue *rq);
+void rq_set_mark(RenderQueue *rq, void (*mark)(void *user, const SDL_Rect *r), void *user);
+// Draw into a target that is `pct` percent of the view size; 100 is 1:1.
+// A new scale drops the scaled copies made for the old one.
+void rq_set_scale(RenderQueue *rq, int pct);
+void rq_begin(RenderQueue *rq, int cameraX, int cameraY, int viewW, int viewH);
+void rq_blit(RenderQueue *rq, int layer, SDL_Surface *src, const SDL_Rect *srcRect, int x, int y);
+// As rq_blit, for a surface reused for different pictures, such as a frame
+// strip's scratch surface; `tag` names the picture it holds now
+void rq_blit_tagged(RenderQueue *rq, int layer, SDL_Surface *src, const SDL_Rect *srcRect, int x, int y, Uint32 tag);
+void rq_fill(RenderQueue *rq, int layer, int x, int y, int w, int h, Uint32 color);
+void rq_flush(RenderQueue *rq, SDL_Surface *screen);
+void rq_report(const RenderQueue *rq, FILE *out);
+
+#endif
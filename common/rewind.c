@@ -0,0 +1,157 @@
+#include "rewind.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Encoded difference: runs of [zeros to skip][n][n changed bytes], each
+// count a byte. Trailing unchanged bytes are not stored at all.
+static Uint32 encodeDelta(const Uint8 *a, const Uint8 *b, int size, Uint8 *out) {
+    Uint32 n = 0;
+    int i = 0;
+    while (i < size) {
+        int skip = 0;
+        while (i < size && skip < 255 && a[i] == b[i]) skip++, i++;
+        if (i == size) break;
+        Uint8 *run = out + n;
+        n += 2;
+        int len = 0;
+        while (i < size && len < 255 && a[i] != b[i]) out[n + len++] = a[i] ^ b[i], i++;
+        run[0] = skip;
+        run[1] = len;
+        n += len;
+    }
+    return n;
+}
+
+static void applyDelta(Uint8 *state, const Uint8 *d, Uint32 size) {
+    Uint32 i = 0;
+    int pos = 0;
+    while (i + 2 <= size) {
+        pos += d[i];
+        int len = d[i + 1];
+        i += 2;
+        for (int k = 0; k < len; k++) state[pos++] ^= d[i + k];
+        i += len;
+    }
+}
+
+static Uint32 microseconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (Uint32)(ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
+
+int rewind_init(Rewind *rw, int stateSize, Uint32 budgetBytes, int interval) {
+    Rewind empty = {0};
+    *rw = empty;
+    // Worst case: every other byte changed, a two-byte run header for each,
+    // plus the empty runs that skip 255 bytes at a time
+    Uint32 worst = 2 * stateSize + 2 * (stateSize / 255) + 4;
+    Uint32 fixed = 2 * stateSize + worst;
+    if (stateSize <= 0 || budgetBytes < fixed + 2 * worst) return -1;
+
+    rw->stateSize = stateSize;
+    rw->interval = interval < 1 ? 1 : interval;
+    rw->cap = budgetBytes - fixed;
+    rw->head = malloc(budgetBytes);
+    if (!rw->head) return -1;
+    rw->mark = rw->head + stateSize;
+    rw->delta = rw->mark + stateSize;
+    rw->data = rw->delta + worst;
+    return 0;
+}
+
+void rewind_free(Rewind *rw) {
+    free(rw->head);
+    rw->head = NULL;
+}
+
+static void evictOldest(Rewind *rw) {
+    rw->first = (rw->first + 1) % REWIND_MAX_ENTRIES;
+    rw->count--;
+    rw->evicted++;
+}
+
+static int overlaps(const RewindEntry *e, Uint32 at, Uint32 size) {
+    return e->offset < at + size && at < e->offset + e->size;
+}
+
+static void push(Rewind *rw, const Uint8 *state) {
+    Uint32 start = microseconds();
+
+    if (rw->hasHead) {
+        Uint32 size = encodeDelta(rw->head, state, rw->stateSize, rw->delta);
+        if (rw->count == REWIND_MAX_ENTRIES) evictOldest(rw);
+
+        // Goes right after the newest entry, or at the start of the ring if
+        // it does not fit before the end
+        Uint32 at = 0;
+        if (rw->count) {
+            const RewindEntry *last = &rw->entries[(rw->first + rw->count - 1) % REWIND_MAX_ENTRIES];
+            at = last->offset + last->size;
+        }
+        if (at + size > rw->cap) {
+            // The oldest entries sit past the newest one; they go first
+            Uint32 end = at;
+            at = 0;
+            while (rw->count && rw->entries[rw->first].offset >= end) evictOldest(rw);
+        }
+        while (rw->count && overlaps(&rw->entries[rw->first], at, size)) evictOldest(rw);
+
+        memcpy(rw->data + at, rw->delta, size);
+        RewindEntry *e = &rw->entries[(rw->first + rw->count) % REWIND_MAX_ENTRIES];
+        e->offset = at;
+        e->size = size;
+        rw->count++;
+    }
+    memcpy(rw->head, state, rw->stateSize);
+    rw->hasHead = 1;
+    rw->snapshots++;
+
+    Uint32 us = microseconds() - start;
+    rw->usTotal += us;
+    if (us > rw->usMax) rw->usMax = us;
+}
+
+void rewind_tick(Rewind *rw, const void *state) {
+    if (rw->tick++ % rw->interval == 0) push(rw, state);
+}
+
+int rewind_back(Rewind *rw, int steps, void *out) {
+    if (!rw->hasHead) return 0;
+    int taken = 0;
+    while (taken < steps && rw->count) {
+        const RewindEntry *e = &rw->entries[(rw->first + rw->count - 1) % REWIND_MAX_ENTRIES];
+        applyDelta(rw->head, rw->data + e->offset, e->size);
+        rw->count--;
+        taken++;
+    }
+    memcpy(out, rw->head, rw->stateSize);
+    // The next recorded tick continues history from the restored state
+    rw->tick = 0;
+    return taken;
+}
+
+int rewind_depth(const Rewind *rw) {
+    return rw->count;
+}
+
+void rewind_mark(Rewind *rw, const void *state) {
+    memcpy(rw->mark, state, rw->stateSize);
+    rw->hasMark = 1;
+}
+
+int rewind_load_mark(const Rewind *rw, void *out) {
+    if (!rw->hasMark) return -1;
+    memcpy(out, rw->mark, rw->stateSize);
+    return 0;
+}
+
+void rewind_report(const Rewind *rw, FILE *out) {
+    if (!rw->snapshots) return;
+    Uint32 used = 0;
+    for (int i = 0; i < rw->count; i++) used += rw->entries[(rw->first + i) % REWIND_MAX_ENTRIES].size;
+    fprintf(out, "rewind: %lu snapshots of %d bytes, %d kept in %lu bytes, %lu dropped, %.1f us avg, %lu us max\n",
+            rw->snapshots, rw->stateSize, rw->count + rw->hasHead, (unsigned long)used, rw->evicted,
+            (double)rw->usTotal / rw->snapshots, (unsigned long)rw->usMax);
+}
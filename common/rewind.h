@@ -0,0 +1,53 @@
+#ifndef REWIND_H
+#define REWIND_H
+
+#include <SDL/SDL.h>
+#include <stdio.h>
+
+// In-memory history of a game's simulation state, for rewind and
+// quick-load. The state is a flat block of bytes the game packs itself.
+//
+// Only the newest snapshot is kept whole. Every older one is stored as the
+// XOR difference to the snapshot after it, run-length coded, so stepping
+// back is one decode and dropping the oldest never breaks the others. All
+// memory is taken once, at init, from the given budget.
+
+#define REWIND_MAX_ENTRIES 1024
+
+typedef struct {
+    Uint32 offset;
+    Uint32 size;
+} RewindEntry;
+
+typedef struct {
+    int stateSize;
+    int interval;           // ticks between snapshots
+    int tick;
+    int hasHead, hasMark;
+    Uint8 *head;            // newest snapshot
+    Uint8 *mark;            // quick-save, kept whole
+    Uint8 *delta;           // encode scratch, worst case sized
+    Uint8 *data;            // ring of encoded differences
+    Uint32 cap;
+    RewindEntry entries[REWIND_MAX_ENTRIES];
+    int first, count;
+    unsigned long snapshots, evicted;
+    Uint32 usTotal, usMax;  // snapshot cost
+} Rewind;
+
+// Fails when the budget cannot hold the fixed buffers plus some history
+int  rewind_init(Rewind *rw, int stateSize, Uint32 budgetBytes, int interval);
+void rewind_free(Rewind *rw);
+// Call once per simulation tick; snapshots every `interval` ticks
+void rewind_tick(Rewind *rw, const void *state);
+// Steps back up to `steps` snapshots, consuming them, and copies the state
+// reached into `out`. Returns the number of steps taken. Don't call
+// rewind_tick while rewinding, or the next step back only undoes that tick.
+int  rewind_back(Rewind *rw, int steps, void *out);
+int  rewind_depth(const Rewind *rw);
+void rewind_mark(Rewind *rw, const void *state);
+// Copies the quick-save into `out`; -1 if there is none
+int  rewind_load_mark(const Rewind *rw, void *out);
+void rewind_report(const Rewind *rw, FILE *out);
+
+#endif
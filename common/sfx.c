@@ -0,0 +1,150 @@
+#include "sfx.h"
+#include <string.h>
+#include <time.h>
+
+static Uint32 microseconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (Uint32)(ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
+
+// Called by SDL_mixer once every channel and the music are mixed, with the
+// audio locked. Adds the active voices on top.
+static void postMix(void *udata, Uint8 *stream, int len) {
+    SfxEngine *sfx = udata;
+    Uint32 now = microseconds();
+    // The buffer being filled plays once the one before it has drained
+    Uint32 bufferUs = (Uint32)((Uint64)(len / sfx->frameBytes) * 1000000 / sfx->freq);
+    Sint16 *dst = (Sint16 *)stream;
+
+    for (int v = 0; v < SFX_VOICES; v++) {
+        SfxVoice *voice = &sfx->voices[v];
+        if (!voice->sound) continue;
+
+        if (!voice->started) {
+            Uint32 latency = now - voice->trigger + bufferUs;
+            voice->started = 1;
+            sfx->measured++;
+            sfx->latencySum += latency;
+            if (latency > sfx->latencyMax) sfx->latencyMax = latency;
+            if (latency > SFX_LATENCY_BUDGET_US) sfx->overBudget++;
+        }
+
+        Mix_Chunk *chunk = voice->sound->chunk;
+        Uint32 left = chunk->alen - voice->pos;
+        Uint32 bytes = left < (Uint32)len ? left : (Uint32)len;
+        const Sint16 *src = (const Sint16 *)(chunk->abuf + voice->pos);
+        for (Uint32 i = 0; i < bytes / 2; i++) {
+            Sint32 s = dst[i] + ((src[i] * chunk->volume) >> 7);
+            dst[i] = s > 32767 ? 32767 : s < -32768 ? -32768 : s;
+        }
+        voice->pos += bytes;
+        if (voice->pos >= chunk->alen) voice->sound = NULL;
+    }
+}
+
+int sfx_init(SfxEngine *sfx) {
+    SfxEngine empty = {0};
+    *sfx = empty;
+
+    int freq, channels;
+    Uint16 format;
+    if (!Mix_QuerySpec(&freq, &format, &channels)) {
+        printf("Failed to start sound effects: %s\n", Mix_GetError());
+        return -1;
+    }
+    sfx->freq = freq;
+    sfx->frameBytes = 2 * channels;
+    if (format == AUDIO_S16SYS) {
+        Mix_SetPostMix(postMix, sfx);
+        sfx->hooked = 1;
+    }
+    return 0;
+}
+
+void sfx_shutdown(SfxEngine *sfx) {
+    if (sfx->hooked) {
+        Mix_SetPostMix(NULL, NULL);
+        sfx->hooked = 0;
+    }
+    for (int i = 0; i < sfx->soundCount; i++) Mix_FreeChunk(sfx->sounds[i].chunk);
+    sfx->soundCount = 0;
+}
+
+int sfx_load(SfxEngine *sfx, const char *path, int priority, Uint32 coalesceMs) {
+    if (sfx->soundCount == SFX_SOUNDS) return -1;
+
+    // Mix_LoadWAV converts to the device format, so mixing is a plain add
+    Mix_Chunk *chunk = Mix_LoadWAV(path);
+    if (!chunk) return -1;
+    if (chunk->alen == 0) {
+        Mix_FreeChunk(chunk);
+        return -1;
+    }
+
+    SfxSound *s = &sfx->sounds[sfx->soundCount];
+    memset(s, 0, sizeof *s);
+    s->chunk = chunk;
+    s->priority = priority;
+    s->coalesceUs = coalesceMs * 1000;
+    return sfx->soundCount++;
+}
+
+// Caller holds the audio lock. A free voice if there is one, otherwise the
+// lowest priority voice that is furthest along; NULL if they all outrank us.
+static SfxVoice *claimVoice(SfxEngine *sfx, int priority) {
+    SfxVoice *victim = NULL;
+    for (int v = 0; v < SFX_VOICES; v++) {
+        SfxVoice *c = &sfx->voices[v];
+        if (!c->sound) return c;
+        if (c->sound->priority > priority) continue;
+        if (!victim || c->sound->priority < victim->sound->priority ||
+            (c->sound->priority == victim->sound->priority && c->pos > victim->pos)) {
+            victim = c;
+        }
+    }
+    if (victim) sfx->stolen++;
+    return victim;
+}
+
+void sfx_play(SfxEngine *sfx, int id) {
+    if (id < 0 || id >= sfx->soundCount) return;
+    SfxSound *s = &sfx->sounds[id];
+    Uint32 now = microseconds();
+
+    sfx->triggers++;
+    // A hover storm becomes one sound instead of a pile of overlapping ones
+    if (s->hasTriggered && now - s->lastTrigger < s->coalesceUs) {
+        sfx->coalesced++;
+        return;
+    }
+    s->lastTrigger = now;
+    s->hasTriggered = 1;
+
+    if (!sfx->hooked) {
+        Mix_PlayChannel(-1, s->chunk, 0);
+        return;
+    }
+
+    SDL_LockAudio();
+    SfxVoice *voice = claimVoice(sfx, s->priority);
+    if (voice) {
+        voice->sound = s;
+        voice->pos = 0;
+        voice->trigger = now;
+        voice->started = 0;
+    } else {
+        sfx->dropped++;
+    }
+    SDL_UnlockAudio();
+}
+
+void sfx_report(const SfxEngine *sfx, FILE *out) {
+    fprintf(out, "sfx: %lu triggers, %lu coalesced, %lu stolen, %lu dropped\n",
+            sfx->triggers, sfx->coalesced, sfx->stolen, sfx->dropped);
+    if (sfx->measured) {
+        fprintf(out, "sfx: latency avg %lu us, max %lu us, %lu of %lu over %d us\n",
+                (unsigned long)(sfx->latencySum / sfx->measured), (unsigned long)sfx->latencyMax,
+                sfx->overBudget, sfx->measured, SFX_LATENCY_BUDGET_US);
+    }
+}
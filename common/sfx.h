@@ -0,0 +1,61 @@
+#ifndef SFX_H
+#define SFX_H
+
+#include <SDL/SDL.h>
+#include <SDL/SDL_mixer.h>
+#include <stdio.h>
+
+// UI sound effects. Sounds are decoded to the device format when loaded and
+// mixed by a post-mix callback into a small fixed pool of voices, so a
+// trigger reaches the speakers within about one device buffer. Each sound
+// has a priority used to steal a voice when the pool is full, and triggers
+// of the same sound closer together than its coalescing window are merged.
+
+// Device buffer in sample frames: 256 frames is 5.8 ms at 44.1 kHz
+#ifndef SFX_BUFFER
+#define SFX_BUFFER 256
+#endif
+
+#define SFX_VOICES 8
+#define SFX_SOUNDS 8
+#define SFX_LATENCY_BUDGET_US 10000
+
+typedef struct {
+    Mix_Chunk *chunk;
+    int priority;           // higher steals from lower
+    Uint32 coalesceUs;
+    Uint32 lastTrigger;
+    int hasTriggered;
+} SfxSound;
+
+typedef struct {
+    SfxSound *sound;        // NULL: free
+    Uint32 pos;             // in bytes
+    Uint32 trigger;         // when sfx_play asked for it, µs
+    int started;
+} SfxVoice;
+
+typedef struct {
+    SfxSound sounds[SFX_SOUNDS];
+    int soundCount;
+
+    // Owned by the audio thread while hooked; change under SDL_LockAudio
+    SfxVoice voices[SFX_VOICES];
+    int hooked;             // 0: device is not S16, play through SDL_mixer channels
+    int freq, frameBytes;
+
+    unsigned long triggers, coalesced, stolen, dropped;
+    unsigned long measured, overBudget;
+    Uint64 latencySum;
+    Uint32 latencyMax;      // trigger to the buffer reaching the device, µs
+} SfxEngine;
+
+// After Mix_OpenAudio
+int  sfx_init(SfxEngine *sfx);
+void sfx_shutdown(SfxEngine *sfx);
+// Returns the sound id, or -1 if it could not be loaded
+int  sfx_load(SfxEngine *sfx, const char *path, int priority, Uint32 coalesceMs);
+void sfx_play(SfxEngine *sfx, int id);
+void sfx_report(const SfxEngine *sfx, FILE *out);
+
+#endif
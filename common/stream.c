@@ -0,0 +1,159 @@
+#include "stream.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static int decoderReady = 0;
+
+static Uint32 microseconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (Uint32)(ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
+
+// Copies into the ring at `head`; the caller checked there is room
+static void ringWrite(MusicStream *ms, const Uint8 *src, Uint32 len) {
+    Uint32 at = ms->head & (STREAM_RING - 1);
+    Uint32 first = len < STREAM_RING - at ? len : STREAM_RING - at;
+    memcpy(ms->ring + at, src, first);
+    memcpy(ms->ring, src + first, len - first);
+    __atomic_store_n(&ms->head, ms->head + len, __ATOMIC_RELEASE);
+}
+
+static int decoderMain(void *data) {
+    MusicStream *ms = data;
+    Uint8 chunk[STREAM_CHUNK];
+    int rewound = 0;
+
+    while (!__atomic_load_n(&ms->quit, __ATOMIC_ACQUIRE)) {
+        Uint32 tail = __atomic_load_n(&ms->tail, __ATOMIC_ACQUIRE);
+        if (STREAM_RING - (ms->head - tail) < STREAM_CHUNK) {
+            SDL_Delay(STREAM_IDLE_MS);
+            continue;
+        }
+
+        size_t done = 0;
+        Uint32 start = microseconds();
+        int err = mpg123_read(ms->mh, chunk, STREAM_CHUNK, &done);
+        Uint32 took = microseconds() - start;
+        if (took > ms->decodeMaxUs) ms->decodeMaxUs = took;
+
+        if (done > 0) {
+            ringWrite(ms, chunk, (Uint32)done);
+            rewound = 0;
+        }
+        if (err == MPG123_OK || err == MPG123_NEW_FORMAT) continue;
+
+        // Loop from the start, unless the track gave nothing since the last
+        // rewind: then it is empty and looping would spin
+        if (err == MPG123_DONE && ms->loop && !rewound && mpg123_seek(ms->mh, 0, SEEK_SET) >= 0) {
+            rewound = 1;
+            continue;
+        }
+        if (err != MPG123_DONE) printf("Music decoding stopped: %s\n", mpg123_strerror(ms->mh));
+        break;
+    }
+    __atomic_store_n(&ms->eof, 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+int stream_open(MusicStream *ms, const char *path, int loop) {
+    MusicStream empty = {0};
+    *ms = empty;
+    ms->loop = loop;
+    ms->volume = MIX_MAX_VOLUME;
+
+    int freq, channels;
+    Uint16 format;
+    if (!Mix_QuerySpec(&freq, &format, &channels) || format != AUDIO_S16SYS) return -1;
+
+    if (!decoderReady) {
+        mpg123_init();
+        decoderReady = 1;
+    }
+    ms->mh = mpg123_new(NULL, NULL);
+    if (!ms->mh) return -1;
+    // Decode straight to the device format; mpg123 resamples if it must
+    mpg123_format_none(ms->mh);
+    if (mpg123_format(ms->mh, freq, channels, MPG123_ENC_SIGNED_16) != MPG123_OK ||
+        mpg123_open(ms->mh, path) != MPG123_OK) {
+        mpg123_delete(ms->mh);
+        ms->mh = NULL;
+        return -1;
+    }
+
+    ms->ring = malloc(STREAM_RING);
+    if (ms->ring) ms->thread = SDL_CreateThread(decoderMain, ms);
+    if (!ms->thread) {
+        printf("Failed to start music decoder: %s\n", SDL_GetError());
+        stream_close(ms);
+        return -1;
+    }
+    return 0;
+}
+
+void stream_close(MusicStream *ms) {
+    if (ms->thread) {
+        __atomic_store_n(&ms->quit, 1, __ATOMIC_RELEASE);
+        SDL_WaitThread(ms->thread, NULL);
+        ms->thread = NULL;
+    }
+    if (ms->mh) {
+        mpg123_close(ms->mh);
+        mpg123_delete(ms->mh);
+        ms->mh = NULL;
+    }
+    free(ms->ring);
+    ms->ring = NULL;
+}
+
+void stream_prime(MusicStream *ms) {
+    while (ms->thread && !__atomic_load_n(&ms->eof, __ATOMIC_ACQUIRE) &&
+           STREAM_RING - (__atomic_load_n(&ms->head, __ATOMIC_ACQUIRE) - ms->tail) >= STREAM_CHUNK) {
+        SDL_Delay(1);
+    }
+}
+
+void stream_read(MusicStream *ms, Uint8 *dst, Uint32 len) {
+    // eof first: once it is set, head is final
+    int eof = __atomic_load_n(&ms->eof, __ATOMIC_ACQUIRE);
+    Uint32 head = __atomic_load_n(&ms->head, __ATOMIC_ACQUIRE);
+    Uint32 n = head - ms->tail < len ? head - ms->tail : len;
+
+    Uint32 at = ms->tail & (STREAM_RING - 1);
+    Uint32 first = n < STREAM_RING - at ? n : STREAM_RING - at;
+    memcpy(dst, ms->ring + at, first);
+    memcpy(dst + first, ms->ring, n - first);
+    __atomic_store_n(&ms->tail, ms->tail + n, __ATOMIC_RELEASE);
+
+    if (n < len) {
+        memset(dst + n, 0, len - n);
+        if (!eof) ms->underruns++;
+    }
+}
+
+// Called by SDL_mixer in place of its music player: a copy and a gain
+static void playHook(void *udata, Uint8 *stream, int len) {
+    MusicStream *ms = udata;
+    stream_read(ms, stream, len);
+    int volume = ms->volume;
+    if (volume < MIX_MAX_VOLUME) {
+        Sint16 *s = (Sint16 *)stream;
+        for (int i = 0; i < len / 2; i++) s[i] = s[i] * volume / MIX_MAX_VOLUME;
+    }
+}
+
+void stream_hook(MusicStream *ms) {
+    stream_prime(ms);
+    Mix_HookMusic(playHook, ms);
+}
+
+void stream_unhook(void) {
+    Mix_HookMusic(NULL, NULL);
+}
+
+void stream_report(const MusicStream *ms, const char *name, FILE *out) {
+    if (!ms->ring) return;
+    fprintf(out, "music %s: %lu underruns, slowest decode step %lu us, ring %d KB\n",
+            name, ms->underruns, (unsigned long)ms->decodeMaxUs, STREAM_RING / 1024);
+}
@@ -0,0 +1,45 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <SDL/SDL.h>
+#include <SDL/SDL_mixer.h>
+#include <mpg123.h>
+#include <stdio.h>
+
+// Music decoded on its own thread into a PCM ring buffer. The decoder is the
+// only writer and the audio callback the only reader, so the ring needs no
+// lock: each side only moves its own counter. A track costs the ring size
+// however long it is, and a frame that is slow to decode eats into the ring
+// rather than into the device buffer.
+
+#define STREAM_RING (256 * 1024)    // bytes, a power of two: 1.5 s of 44.1 kHz stereo
+#define STREAM_CHUNK 4096           // decoded per step
+#define STREAM_IDLE_MS 5            // decoder nap while the ring is full
+
+typedef struct {
+    Uint8 *ring;
+    Uint32 head;            // bytes ever written, moved by the decoder
+    Uint32 tail;            // bytes ever read, moved by the reader
+    int eof, quit;
+    mpg123_handle *mh;
+    int loop;
+    SDL_Thread *thread;
+    int volume;             // 0..MIX_MAX_VOLUME, applied by stream_hook
+    unsigned long underruns;
+    Uint32 decodeMaxUs;     // slowest single decode step
+} MusicStream;
+
+// After Mix_OpenAudio, on a 16-bit device. Starts the decoder thread.
+int  stream_open(MusicStream *ms, const char *path, int loop);
+// Nobody may be reading any more
+void stream_close(MusicStream *ms);
+// Waits until the ring is full, or the track has ended
+void stream_prime(MusicStream *ms);
+// Reader side. Short reads are padded with silence and count as an underrun.
+void stream_read(MusicStream *ms, Uint8 *dst, Uint32 len);
+// Plays one primed stream in place of SDL_mixer's music player
+void stream_hook(MusicStream *ms);
+void stream_unhook(void);
+void stream_report(const MusicStream *ms, const char *name, FILE *out);
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+#include <SDL/SDL.h>
+
+// World-space coordinates. SDL_Rect only has 16-bit fields, so positions live
+// here as 32-bit values and become SDL_Rects only at the final screen blit.
+
+// 24.8 fixed point: 1/256 px of subpixel motion, worlds up to +-8M px
+typedef Sint32 fixed_t;
+#define FIX_SHIFT 8
+#define FIX_ONE (1 << FIX_SHIFT)
+#define INT_TO_FIX(v) ((fixed_t)(v) * FIX_ONE)
+#define FIX_TO_INT(v) ((int)((v) >> FIX_SHIFT))   // rounds toward -inf
+
+typedef struct {
+    Sint32 x, y, w, h;
+} WorldRect;
+
+static inline int world_overlap(WorldRect a, WorldRect b) {
+    return a.x < b.x + b.w &&
+           a.x + a.w > b.x &&
+           a.y < b.y + b.h &&
+           a.y + a.h > b.y;
+}
+
+// Screen-space rect for a world rect; callers cull first, the clamp only
+// guards against wrapping the 16-bit fields.
+static inline SDL_Rect world_to_screen(WorldRect r, Sint32 cameraX, Sint32 cameraY) {
+    Sint32 x = r.x - cameraX, y = r.y - cameraY;
+    SDL_Rect out;
+    out.x = (Sint16)(x < -32768 ? -32768 : x > 32767 ? 32767 : x);
+    out.y = (Sint16)(y < -32768 ? -32768 : y > 32767 ? 32767 : y);
+    out.w = (Uint16)(r.w > 65535 ? 65535 : r.w);
+    out.h = (Uint16)(r.h > 65535 ? 65535 : r.h);
+    return out;
+}
+
+#endif
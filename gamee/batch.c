@@ -0,0 +1,170 @@
+// batch.c
+// Headless batch runs: every run owns its GameSim and RNG streams, so the
+// result of a seed does not depend on which worker stepped it
+#include "batch.h"
+#include "sim.h"
+#include "tiles.h"
+#include "jobs.h"
+#include <stdlib.h>
+#include <time.h>
+
+// Both levels plus their pauses, with room to spare; a run never gets near it
+#define BATCH_MAX_FRAMES (((LEVEL1_TIME + LEVEL2_TIME) * 1000 + 4 * LEVEL_PAUSE_MS) * 2 / BATCH_DT_MS)
+
+typedef struct {
+    int score, level1_score;
+    Uint32 first_kill_ms;   // 0 if nothing was hit
+    Uint32 sim_ms;
+    int frames;
+} RunResult;
+
+typedef struct {
+    const AnimSet* clips;
+    int world_w;
+    Uint32 seed;
+    BotKind bot;
+    RunResult* results;
+} BatchJob;
+
+// Random: holds a random action for a random number of frames
+static void bot_random(GameSim* s, Uint32* rng, int* hold) {
+    if (--*hold > 0) return;
+    *hold = 5 + rng_next(rng) % 40;
+    static const int moves[] = {ACT_LEFT, ACT_RIGHT, ACT_RIGHT, ACT_STOP, ACT_JUMP, ACT_ATTACK, ACT_ATTACK};
+    sim_act(s, moves[rng_next(rng) % (int)(sizeof(moves) / sizeof(moves[0]))]);
+}
+
+// Chase: walks to the nearest enemy on screen and swings once in reach
+static void bot_chase(GameSim* s) {
+    int px = FIX_TO_INT(s->player.x);
+    int best = -1, best_d = 0;
+    for (int i = 0; i < s->enemy_count; ++i) {
+        const Enemy* e = &s->enemies[i];
+        if (!e->alive) continue;
+        int d = e->x + e->w / 2 - (px + WALK_W / 2);
+        if (best < 0 || abs(d) < abs(best_d)) {
+            best = i;
+            best_d = d;
+        }
+    }
+    if (best < 0) {
+        sim_act(s, ACT_STOP);
+        return;
+    }
+    const Enemy* e = &s->enemies[best];
+    // Reach of the swing, as sim_step tests it
+    int lo = s->player.facing_right ? px + WALK_W : px - 40;
+    int hi = s->player.facing_right ? px + WALK_W + ATTACK_W : px;
+    int facing_it = (best_d > 0) == (s->player.facing_right != 0);
+    if (facing_it && e->x < hi && e->x + e->w > lo) {
+        sim_act(s, ACT_STOP);
+        sim_act(s, ACT_ATTACK);
+    } else {
+        sim_act(s, best_d > 0 ? ACT_RIGHT : ACT_LEFT);
+    }
+}
+
+static void run_range(void* ctx, int begin, int end) {
+    BatchJob* job = ctx;
+    for (int run = begin; run < end; ++run) {
+        GameSim sim;
+        RunResult* r = &job->results[run];
+        if (sim_init(&sim, job->world_w, rng_seed(job->seed, 2 * run)) != 0) {
+            r->frames = -1;
+            continue;
+        }
+        Uint32 bot_rng = rng_seed(job->seed, 2 * run + 1);
+        int hold = 0;
+        r->score = r->level1_score = 0;
+        r->first_kill_ms = 0;
+        for (r->frames = 0; !sim.over && r->frames < BATCH_MAX_FRAMES; ++r->frames) {
+            if (job->bot == BOT_CHASE) bot_chase(&sim);
+            else bot_random(&sim, &bot_rng, &hold);
+            sim_step(&sim, job->clips, BATCH_DT_MS);
+            sim.hold_ms = 0;
+            if (!r->first_kill_ms && sim.score > 0) r->first_kill_ms = sim.clock;
+        }
+        r->score = sim.score;
+        r->level1_score = sim.level1_score;
+        r->sim_ms = sim.clock;
+        sim_free(&sim);
+    }
+}
+
+static int cmp_int(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// Sorted values: min p10 p50 p90 max and the mean
+static void print_distribution(FILE* out, const char* label, int* v, int n, double scale) {
+    qsort(v, n, sizeof(int), cmp_int);
+    double sum = 0;
+    for (int i = 0; i < n; ++i) sum += v[i];
+    fprintf(out, "  %-12s min %7.1f  p10 %7.1f  p50 %7.1f  p90 %7.1f  max %7.1f  mean %7.2f\n", label,
+            v[0] * scale, v[n / 10] * scale, v[n / 2] * scale, v[n * 9 / 10] * scale, v[n - 1] * scale, sum / n * scale);
+}
+
+static double wall_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int run_batch(int runs, Uint32 seed, BotKind bot, FILE* out) {
+    if (runs <= 0) return -1;
+    AnimSet clips;
+    TiledBackground bg;
+    if (sim_load_clips(&clips) != 0 || tiles_open(&bg, "jeu/background.tiles") != 0) {
+        fprintf(stderr, "Error loading game assets\n");
+        return -1;
+    }
+    // Only the world size matters without a screen
+    int world_w = bg.width;
+    tiles_close(&bg);
+
+    RunResult* results = calloc(runs, sizeof(RunResult));
+    int* values = calloc(runs, sizeof(int));
+    if (!results || !values || jobs_init(0) != 0) {
+        free(results);
+        free(values);
+        return -1;
+    }
+    BatchJob job = {&clips, world_w, seed, bot, results};
+    double start = wall_seconds();
+    jobs_parallel_for(runs, 1, run_range, &job);
+    double wall = wall_seconds() - start;
+    int workers = jobs_worker_count();
+    jobs_shutdown();
+
+    int n = 0, stuck = 0, killed = 0;
+    double sim_s = 0;
+    for (int i = 0; i < runs; ++i) {
+        if (results[i].frames < 0) continue;
+        if (results[i].frames >= BATCH_MAX_FRAMES) stuck++;
+        if (results[i].first_kill_ms) killed++;
+        sim_s += results[i].sim_ms / 1000.0;
+        results[n++] = results[i];
+    }
+    fprintf(out, "batch: %d runs (%s bot, seed %u) on %d workers, %.0f simulated s in %.2f s wall, %.0fx real time\n",
+            n, bot == BOT_CHASE ? "chase" : "random", seed, workers, sim_s, wall, wall > 0 ? sim_s / wall : 0);
+    if (n) {
+        fprintf(out, "batch: levels of %d s and %d s, hp %d/%d, %d enemies up\n",
+                LEVEL1_TIME, LEVEL2_TIME, LEVEL1_HP, LEVEL2_HP, MAX_ALIVE);
+        for (int i = 0; i < n; ++i) values[i] = results[i].score;
+        print_distribution(out, "score", values, n, 1);
+        for (int i = 0; i < n; ++i) values[i] = results[i].level1_score;
+        print_distribution(out, "level 1", values, n, 1);
+        for (int i = 0; i < n; ++i) values[i] = results[i].score - results[i].level1_score;
+        print_distribution(out, "level 2", values, n, 1);
+        int k = 0;
+        for (int i = 0; i < n; ++i) {
+            if (results[i].first_kill_ms) values[k++] = results[i].first_kill_ms;
+        }
+        if (k) print_distribution(out, "first kill s", values, k, 0.001);
+        fprintf(out, "batch: %d of %d runs scored, %d hit the frame cap\n", killed, n, stuck);
+    }
+    free(results);
+    free(values);
+    return n ? 0 : -1;
+}
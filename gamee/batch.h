@@ -0,0 +1,17 @@
+// batch.h
+// Headless runs of run_game() for balancing: many seeded games stepped in
+// parallel with no window and no frame limiter, bots at the controls
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <SDL/SDL.h>
+#include <stdio.h>
+
+#define BATCH_DT_MS 16          // one simulated frame, as the game loop's delay
+
+typedef enum { BOT_RANDOM, BOT_CHASE } BotKind;
+
+// Runs `runs` games seeded from `seed`, prints the aggregate; 0 on success
+int run_batch(int runs, Uint32 seed, BotKind bot, FILE* out);
+
+#endif
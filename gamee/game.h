@@ -0,0 +1,47 @@
+// game.h
+// Shared definitions for the side-scrolling game in run_game()
+#ifndef GAME_H
+#define GAME_H
+
+#include <SDL/SDL.h>
+#include "world.h"
+#include "anim.h"
+
+#define SCREEN_WIDTH 1280
+#define SCREEN_HEIGHT 720
+#define MAX_ENEMIES 10
+
+// --- Game definitions ---
+#define PLAYER_W 71
+#define PLAYER_H 79
+#define PLAYER_SPEED 5
+#define JUMP_VELOCITY -15
+#define GRAVITY 1
+#define GROUND_Y 810
+#define WALK_FRAMES 9
+#define ATTACK_FRAMES 6
+#define ATTACK_W 121
+#define WALK_W 71
+
+// Player animation clips and events, in the order anim_load resolves them
+enum { CLIP_STAND, CLIP_WALK, CLIP_ATTACK, CLIP_COUNT };
+enum { EVENT_HIT, EVENT_COUNT };
+
+// Player structure, position and velocity in 24.8 fixed point
+typedef struct {
+    fixed_t x, y;
+    fixed_t vx, vy;
+    int on_ground;
+    int facing_right;
+    int attacking;
+    AnimState anim;
+} Player;
+
+// Enemy structure, world pixels
+typedef struct {
+    Sint32 x, y, w, h;
+    int alive;
+    int hp;
+} Enemy;
+
+#endif
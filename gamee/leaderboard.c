@@ -0,0 +1,288 @@
+// leaderboard.c
+// Top-K index over the append-only score log
+#include "leaderboard.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define INDEX_MAGIC "LBIX"
+#define INDEX_VERSION 1
+#define CATCHUP_BATCH 4096      // log lines folded per lock hold
+
+static size_t index_bytes(Uint32 slots) {
+    return sizeof(LeaderHeader) + (LEADERBOARD_TOP + (size_t)slots) * sizeof(LeaderEntry);
+}
+
+static void map_sections(Leaderboard* lb) {
+    lb->top = (LeaderEntry*)(lb->header + 1);
+    lb->names = lb->top + LEADERBOARD_TOP;
+}
+
+static int map_index(Leaderboard* lb, size_t size) {
+    if (ftruncate(lb->index_fd, size) != 0) return -1;
+    void* p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, lb->index_fd, 0);
+    if (p == MAP_FAILED) return -1;
+    lb->header = p;
+    lb->index_size = size;
+    map_sections(lb);
+    return 0;
+}
+
+static Uint32 name_hash(const char* name) {
+    Uint32 h = 2166136261u;
+    for (int i = 0; i < LEADERBOARD_NAME && name[i]; ++i) h = (h ^ (Uint8)name[i]) * 16777619u;
+    return h;
+}
+
+// Slot holding `name`, or the free slot where it would go
+static LeaderEntry* name_slot(Leaderboard* lb, const char* name) {
+    Uint32 mask = lb->header->name_slots - 1;
+    Uint32 i = name_hash(name) & mask;
+    while (lb->names[i].name[0] && strncmp(lb->names[i].name, name, LEADERBOARD_NAME) != 0) i = (i + 1) & mask;
+    return &lb->names[i];
+}
+
+static int grow_names(Leaderboard* lb) {
+    Uint32 old_slots = lb->header->name_slots;
+    LeaderEntry* old = malloc(old_slots * sizeof(LeaderEntry));
+    if (!old) return -1;
+    memcpy(old, lb->names, old_slots * sizeof(LeaderEntry));
+
+    // Map the grown file before letting go of the old mapping, so a failure
+    // leaves the index as it was
+    LeaderHeader* old_header = lb->header;
+    size_t old_size = lb->index_size;
+    if (map_index(lb, index_bytes(old_slots * 2)) != 0) {
+        if (ftruncate(lb->index_fd, old_size) != 0) {
+            // Left longer than its slots say, it is rebuilt on the next open
+        }
+        free(old);
+        return -1;
+    }
+    munmap(old_header, old_size);
+    lb->header->name_slots = old_slots * 2;
+    memset(lb->names, 0, lb->header->name_slots * sizeof(LeaderEntry));
+    for (Uint32 i = 0; i < old_slots; ++i) {
+        if (old[i].name[0]) *name_slot(lb, old[i].name) = old[i];
+    }
+    free(old);
+    return 0;
+}
+
+// Removes `name` from the ranking if present, then inserts it at its
+// place: binary search on the descending scores, equal scores keep their
+// order. Past LEADERBOARD_TOP it simply drops off.
+static void rank(Leaderboard* lb, const char* name, Sint32 score) {
+    LeaderEntry* top = lb->top;
+    int n = lb->header->top_count;
+    for (int i = 0; i < n; ++i) {
+        if (strncmp(top[i].name, name, LEADERBOARD_NAME) == 0) {
+            memmove(&top[i], &top[i + 1], (n - i - 1) * sizeof(LeaderEntry));
+            n--;
+            break;
+        }
+    }
+    int lo = 0, hi = n;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (top[mid].score >= score) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo < LEADERBOARD_TOP) {
+        if (n == LEADERBOARD_TOP) n--;
+        memmove(&top[lo + 1], &top[lo], (n - lo) * sizeof(LeaderEntry));
+        memset(&top[lo], 0, sizeof(LeaderEntry));
+        strncpy(top[lo].name, name, LEADERBOARD_NAME - 1);
+        top[lo].score = score;
+        n++;
+    }
+    lb->header->top_count = n;
+}
+
+// Keeping only bests makes folding idempotent: a line seen twice changes nothing
+static void fold(Leaderboard* lb, const char* name, Sint32 score) {
+    if (!name[0]) return;
+    LeaderEntry* slot = name_slot(lb, name);
+    if (slot->name[0]) {
+        if (score <= slot->score) return;
+    } else {
+        if ((lb->header->name_count + 1) * 4 > lb->header->name_slots * 3) {
+            if (grow_names(lb) != 0) return;
+            slot = name_slot(lb, name);
+        }
+        strncpy(slot->name, name, LEADERBOARD_NAME - 1);
+        lb->header->name_count++;
+    }
+    slot->score = score;
+    rank(lb, slot->name, score);
+}
+
+// "name score", where the name may itself contain spaces
+static int parse_line(char* line, char* name, Sint32* score) {
+    size_t len = strcspn(line, "\r\n");
+    line[len] = '\0';
+    char* sep = strrchr(line, ' ');
+    if (!sep || sep == line) return -1;
+    char* end;
+    long v = strtol(sep + 1, &end, 10);
+    if (end == sep + 1 || *end) return -1;
+    size_t n = sep - line;
+    if (n > LEADERBOARD_NAME - 1) n = LEADERBOARD_NAME - 1;
+    memcpy(name, line, n);
+    name[n] = '\0';
+    *score = (Sint32)v;
+    return 0;
+}
+
+static int catchup_main(void* data) {
+    Leaderboard* lb = data;
+    FILE* f = fopen(lb->log_path, "r");
+    if (!f) return 0;
+
+    SDL_mutexP(lb->lock);
+    long pos = (long)lb->header->log_offset;
+    SDL_mutexV(lb->lock);
+    if (fseek(f, pos, SEEK_SET) != 0) {
+        fclose(f);
+        return 0;
+    }
+
+    char line[128], name[LEADERBOARD_NAME];
+    Sint32 score;
+    int done = 0;
+    while (!done) {
+        SDL_mutexP(lb->lock);
+        for (int n = 0; n < CATCHUP_BATCH; ++n) {
+            if (lb->quit || !fgets(line, sizeof(line), f)) {
+                done = 1;
+                break;
+            }
+            if (!strchr(line, '\n')) {
+                // A line still being written is picked up next time
+                if (feof(f)) {
+                    done = 1;
+                    break;
+                }
+                // One longer than any score line: skip to the next
+                int c;
+                while ((c = fgetc(f)) != EOF && c != '\n') {}
+                if (c == EOF) {
+                    done = 1;
+                    break;
+                }
+                pos = ftell(f);
+                continue;
+            }
+            if (parse_line(line, name, &score) == 0) fold(lb, name, score);
+            pos = ftell(f);
+        }
+        lb->header->log_offset = pos;
+        SDL_mutexV(lb->lock);
+    }
+    fclose(f);
+    return 0;
+}
+
+static void reset_index(Leaderboard* lb) {
+    memset(lb->header, 0, lb->index_size);
+    memcpy(lb->header->magic, INDEX_MAGIC, 4);
+    lb->header->version = INDEX_VERSION;
+    lb->header->name_slots = LEADERBOARD_MIN_SLOTS;
+}
+
+int leaderboard_open(Leaderboard* lb, const char* log_path, const char* index_path) {
+    memset(lb, 0, sizeof(*lb));
+    lb->index_fd = open(index_path, O_RDWR | O_CREAT, 0644);
+    lb->log_path = strdup(log_path);
+    lb->log = fopen(log_path, "a");
+    lb->lock = SDL_CreateMutex();
+    if (lb->index_fd < 0 || !lb->log_path || !lb->log || !lb->lock) {
+        leaderboard_close(lb);
+        return -1;
+    }
+
+    // Keep an index that matches this build and its own size, else start over
+    struct stat st;
+    int valid = 0;
+    if (fstat(lb->index_fd, &st) == 0 && (size_t)st.st_size >= sizeof(LeaderHeader) &&
+        map_index(lb, st.st_size) == 0) {
+        LeaderHeader* h = lb->header;
+        valid = memcmp(h->magic, INDEX_MAGIC, 4) == 0 && h->version == INDEX_VERSION &&
+                h->name_slots >= LEADERBOARD_MIN_SLOTS && (h->name_slots & (h->name_slots - 1)) == 0 &&
+                index_bytes(h->name_slots) == (size_t)st.st_size && h->top_count <= LEADERBOARD_TOP;
+        if (!valid) munmap(lb->header, lb->index_size);
+    }
+    if (!valid) {
+        if (map_index(lb, index_bytes(LEADERBOARD_MIN_SLOTS)) != 0) {
+            lb->header = NULL;
+            leaderboard_close(lb);
+            return -1;
+        }
+        reset_index(lb);
+    }
+    // A log shorter than what was folded was replaced: fold it again
+    fseek(lb->log, 0, SEEK_END);
+    if (ftell(lb->log) < (long)lb->header->log_offset) reset_index(lb);
+
+    lb->thread = SDL_CreateThread(catchup_main, lb);
+    if (!lb->thread) {
+        // Without the thread, catch up right here
+        catchup_main(lb);
+    }
+    return 0;
+}
+
+void leaderboard_close(Leaderboard* lb) {
+    if (lb->thread) {
+        SDL_mutexP(lb->lock);
+        lb->quit = 1;
+        SDL_mutexV(lb->lock);
+        SDL_WaitThread(lb->thread, NULL);
+    }
+    if (lb->header) {
+        msync(lb->header, lb->index_size, MS_SYNC);
+        munmap(lb->header, lb->index_size);
+    }
+    if (lb->index_fd >= 0) close(lb->index_fd);
+    if (lb->log) fclose(lb->log);
+    if (lb->lock) SDL_DestroyMutex(lb->lock);
+    free(lb->log_path);
+    memset(lb, 0, sizeof(*lb));
+    lb->index_fd = -1;
+}
+
+int leaderboard_add(Leaderboard* lb, const char* name, int score) {
+    if (!lb->header) return -1;
+    char clean[LEADERBOARD_NAME];
+    strncpy(clean, name, LEADERBOARD_NAME - 1);
+    clean[LEADERBOARD_NAME - 1] = '\0';
+    if (!clean[0]) return -1;
+
+    if (fprintf(lb->log, "%s %d\n", clean, score) < 0 || fflush(lb->log) != 0) return -1;
+    SDL_mutexP(lb->lock);
+    fold(lb, clean, score);
+    SDL_mutexV(lb->lock);
+    return 0;
+}
+
+int leaderboard_top(Leaderboard* lb, LeaderEntry* out, int max) {
+    if (!lb->header) return 0;
+    SDL_mutexP(lb->lock);
+    int n = (int)lb->header->top_count < max ? (int)lb->header->top_count : max;
+    memcpy(out, lb->top, n * sizeof(LeaderEntry));
+    SDL_mutexV(lb->lock);
+    return n;
+}
+
+int leaderboard_best(Leaderboard* lb, const char* name, int* score) {
+    if (!lb->header) return -1;
+    SDL_mutexP(lb->lock);
+    LeaderEntry* slot = name_slot(lb, name);
+    int found = slot->name[0] != '\0';
+    if (found) *score = slot->score;
+    SDL_mutexV(lb->lock);
+    return found ? 0 : -1;
+}
@@ -0,0 +1,53 @@
+// leaderboard.h
+// Score history and leaderboard: every score is appended to a text log,
+// and a memory-mapped index keeps the top scores and each name's best
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+#include <SDL/SDL.h>
+#include <stdio.h>
+
+#define LEADERBOARD_TOP 64          // distinct names kept ranked
+#define LEADERBOARD_NAME 16
+#define LEADERBOARD_MIN_SLOTS 1024  // initial size of the per-name table
+
+typedef struct {
+    char name[LEADERBOARD_NAME];    // NUL-terminated, empty for a free slot
+    Sint32 score;
+} LeaderEntry;
+
+// Index file layout: this header, the ranked top, then the per-name table.
+// It only caches what the log says, so a bad or outdated one is rebuilt.
+typedef struct {
+    char magic[4];
+    Uint32 version;
+    Uint32 top_count;
+    Uint32 name_slots;              // power of two, open addressing
+    Uint32 name_count;
+    Uint32 reserved;
+    Uint64 log_offset;              // log bytes already folded in
+} LeaderHeader;
+
+typedef struct {
+    FILE* log;                      // append handle
+    char* log_path;
+    int index_fd;
+    size_t index_size;
+    LeaderHeader* header;           // mapping of the whole index file
+    LeaderEntry* top;
+    LeaderEntry* names;
+    SDL_mutex* lock;
+    SDL_Thread* thread;             // folds in log lines the index has not seen
+    int quit;
+} Leaderboard;
+
+int leaderboard_open(Leaderboard* lb, const char* log_path, const char* index_path);
+// Waits for the catch-up thread, which resumes from where it stopped next time
+void leaderboard_close(Leaderboard* lb);
+int leaderboard_add(Leaderboard* lb, const char* name, int score);
+// Copies the best `max` distinct names, highest first; returns how many
+int leaderboard_top(Leaderboard* lb, LeaderEntry* out, int max);
+// -1 if the name has no score yet
+int leaderboard_best(Leaderboard* lb, const char* name, int* score);
+
+#endif
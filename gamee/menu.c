@@ -4,17 +4,33 @@
 #include <SDL/SDL_image.h>
 #include <SDL/SDL_ttf.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
 #include <time.h>
 #include <ctype.h>
+#include "game.h"
+#include "sector.h"
+#include "sim.h"
+#include "batch.h"
+#include "render_queue.h"
+#include "tiles.h"
+#include "scroll.h"
+#include "highlight.h"
+#include "scratch.h"
+#include "rewind.h"
+#include "leaderboard.h"
+#include "input.h"
+#include "capture.h"
+
+// Render queue layers for world sprites
+#define LAYER_ENEMIES 1
+#define LAYER_PLAYER 2
 
-#define SCREEN_WIDTH 1280
-#define SCREEN_HEIGHT 720
 #define BUTTON_COUNT 5
-#define MAX_ENEMIES 10
 #define MAX_NAME_LEN 16
-#define MAX_SCORES 20
+#define REWIND_BUDGET (256 * 1024)
+#define REWIND_INTERVAL 2   // frames between history snapshots
 
 // Button identifiers
 enum ButtonType { APPEARANCE1, APPEARANCE2, INPUT1, INPUT2, CONFIRM };
@@ -35,13 +51,6 @@ const char* button_files[BUTTON_COUNT] = {
     "menu/buttons/input2.png",
     "menu/buttons/confirm.png"
 };
-const char* button_files_h[BUTTON_COUNT] = {
-    "menu/buttons/h/appearance1.png",
-    "menu/buttons/h/appearance2.png",
-    "menu/buttons/h/input1.png",
-    "menu/buttons/h/input2.png",
-    "menu/buttons/h/confirm.png"
-};
 
 // Button positions (x, y, w, h)
 SDL_Rect button_rects[BUTTON_COUNT] = {
@@ -52,54 +61,33 @@ SDL_Rect button_rects[BUTTON_COUNT] = {
     {300, 400, 200, 60}  // confirm
 };
 
-// --- Game definitions ---
-#define PLAYER_W 71
-#define PLAYER_H 79
-#define PLAYER_SPEED 5
-#define JUMP_VELOCITY -15
-#define GRAVITY 1
-#define GROUND_Y 810
-#define WALK_FRAMES 9
-#define ATTACK_FRAMES 6
-#define ATTACK_W 121
-#define WALK_W 71
+// Every score ever entered, plus the ranked best per name; opened for the
+// whole run so the index catches up with the log in the background
+static Leaderboard leaderboard;
 
-// Player structure
-typedef struct {
-    int x, y;
-    int vx, vy;
-    int on_ground;
-    int facing_right;
-    int attacking;
-    int walk_frame;
-    int attack_frame;
-} Player;
+// --record: capture run_game() to a video stream from its first frame
+static int record_game = 0;
 
-// Enemy structure
+// Simulation state of run_game() for rewind and quick-load; the snapshot
+// buffer holds this followed by the contents of every sector
 typedef struct {
-    int x, y, w, h;
-    int alive;
-    int hp;
-} Enemy;
-
-typedef struct {
-    char name[MAX_NAME_LEN];
-    int score;
-} ScoreEntry;
+    GameSim sim;
+} GameSnapshot;
 
 void run_game();
 
 // Function prototypes
 void draw_menu(SDL_Surface* screen, SDL_Surface* bg, Button* buttons);
 int handle_menu();
-void draw_fade_and_text(SDL_Surface* screen, int alpha, const char* text, SDL_Color color, TTF_Font* font);
-void spawn_enemy(Enemy* e, int hp, int camera_x);
+void draw_fade_and_text(SDL_Surface* screen, ScratchArena* scratch, TextSlot* slot, int alpha, const char* text, SDL_Color color, TTF_Font* font);
 void save_score(const char* name, int score);
-int load_scores(ScoreEntry* entries, int max);
-int cmp_score(const void* a, const void* b);
 void show_score_menu(int final_score);
 void show_best_scores();
 
+static void mark_scroll_dirty(void* user, const SDL_Rect* r) {
+    scroll_mark((ScrollLayer*)user, r);
+}
+
 void draw_menu(SDL_Surface* screen, SDL_Surface* bg, Button* buttons) {
     SDL_BlitSurface(bg, NULL, screen, NULL);
     for (int i = 0; i < BUTTON_COUNT; ++i) {
@@ -117,7 +105,8 @@ int handle_menu() {
     for (int i = 0; i < BUTTON_COUNT; ++i) {
         buttons[i].rect = button_rects[i];
         buttons[i].normal = IMG_Load(button_files[i]);
-        buttons[i].highlighted = IMG_Load(button_files_h[i]);
+        // Highlight is generated from the normal image, not loaded
+        buttons[i].highlighted = highlight_make(buttons[i].normal, HIGHLIGHT_GLOW);
         buttons[i].selected = false;
     }
     int running = 1;
@@ -170,50 +159,24 @@ int handle_menu() {
     return 0;
 }
 
-void draw_fade_and_text(SDL_Surface* screen, int alpha, const char* text, SDL_Color color, TTF_Font* font) {
-    SDL_Surface* fade = SDL_CreateRGBSurface(SDL_SWSURFACE, SCREEN_WIDTH, SCREEN_HEIGHT, 32,
-        0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
-    SDL_FillRect(fade, NULL, SDL_MapRGBA(fade->format, 0, 0, 0, alpha));
-    SDL_SetAlpha(fade, SDL_SRCALPHA, alpha);
-    SDL_BlitSurface(fade, NULL, screen, NULL);
-    SDL_FreeSurface(fade);
+void draw_fade_and_text(SDL_Surface* screen, ScratchArena* scratch, TextSlot* slot, int alpha, const char* text, SDL_Color color, TTF_Font* font) {
+    // Black in the screen's own format, blended with per-surface alpha
+    ScratchSurface fade = scratch_get(scratch, SCREEN_WIDTH, SCREEN_HEIGHT, screen->format);
+    if (fade.surf) {
+        SDL_FillRect(fade.surf, &fade.area, SDL_MapRGB(fade.surf->format, 0, 0, 0));
+        SDL_SetAlpha(fade.surf, SDL_SRCALPHA, alpha);
+        SDL_BlitSurface(fade.surf, &fade.area, screen, NULL);
+    }
     if (text && font) {
-        SDL_Surface* txt = TTF_RenderText_Solid(font, text, color);
+        SDL_Surface* txt = text_slot_render(slot, font, text, color);
+        if (!txt) return;
         SDL_Rect dst = {SCREEN_WIDTH / 2 - txt->w / 2, SCREEN_HEIGHT / 2 - txt->h / 2, txt->w, txt->h};
         SDL_BlitSurface(txt, NULL, screen, &dst);
-        SDL_FreeSurface(txt);
     }
 }
 
-void spawn_enemy(Enemy* e, int hp, int camera_x) {
-    e->w = 60;
-    e->h = 80;
-    e->x = camera_x + 100 + rand() % (SCREEN_WIDTH - 200 - e->w);
-    e->y = GROUND_Y - e->h;
-    e->alive = 1;
-    e->hp = hp;
-}
-
 void save_score(const char* name, int score) {
-    FILE* f = fopen("score.txt", "a");
-    if (f) {
-        fprintf(f, "%s %d\n", name, score);
-        fclose(f);
-    }
-}
-
-int load_scores(ScoreEntry* entries, int max) {
-    FILE* f = fopen("score.txt", "r");
-    int n = 0;
-    if (f) {
-        while (n < max && fscanf(f, "%15s %d", entries[n].name, &entries[n].score) == 2) n++;
-        fclose(f);
-    }
-    return n;
-}
-
-int cmp_score(const void* a, const void* b) {
-    return ((ScoreEntry*)b)->score - ((ScoreEntry*)a)->score;
+    if (leaderboard_add(&leaderboard, name, score) != 0) fprintf(stderr, "Could not save score\n");
 }
 
 void show_score_menu(int final_score) {
@@ -224,24 +187,23 @@ void show_score_menu(int final_score) {
     int name_len = 0;
     int done = 0;
     SDL_Event e;
+    // Only the name changes while typing, the other two render once
+    TextSlot prompt_text = {0}, name_text = {0}, score_text = {0};
     while (!done) {
         SDL_BlitSurface(bg, NULL, screen, NULL);
         SDL_Color white = {255,255,255};
-        SDL_Surface* prompt = TTF_RenderText_Solid(font, "Enter your name:", white);
+        SDL_Surface* prompt = text_slot_render(&prompt_text, font, "Enter your name:", white);
         SDL_Rect pdst = {SCREEN_WIDTH/2 - prompt->w/2, 200, prompt->w, prompt->h};
         SDL_BlitSurface(prompt, NULL, screen, &pdst);
-        SDL_FreeSurface(prompt);
-        SDL_Surface* name_surf = TTF_RenderText_Solid(font, name, white);
+        SDL_Surface* name_surf = text_slot_render(&name_text, font, name, white);
         SDL_Rect ndst = {SCREEN_WIDTH/2 - 200, 300, 400, 60};
         SDL_FillRect(screen, &ndst, SDL_MapRGB(screen->format, 0,0,0));
         SDL_BlitSurface(name_surf, NULL, screen, &ndst);
-        SDL_FreeSurface(name_surf);
         char score_str[32];
         sprintf(score_str, "Score: %d", final_score);
-        SDL_Surface* s_surf = TTF_RenderText_Solid(font, score_str, white);
+        SDL_Surface* s_surf = text_slot_render(&score_text, font, score_str, white);
         SDL_Rect sdst = {SCREEN_WIDTH/2 - s_surf->w/2, 400, s_surf->w, s_surf->h};
         SDL_BlitSurface(s_surf, NULL, screen, &sdst);
-        SDL_FreeSurface(s_surf);
         SDL_Flip(screen);
         while (SDL_PollEvent(&e)) {
             if (e.type == SDL_QUIT) exit(0);
@@ -263,6 +225,9 @@ void show_score_menu(int final_score) {
             }
         }
     }
+    text_slot_free(&prompt_text);
+    text_slot_free(&name_text);
+    text_slot_free(&score_text);
     SDL_FreeSurface(bg);
     TTF_CloseFont(font);
 }
@@ -272,9 +237,8 @@ void show_best_scores() {
     SDL_Surface* board = IMG_Load("menu/board.png");
     SDL_Surface* title = IMG_Load("menu/best_score.png");
     TTF_Font* font = TTF_OpenFont("font.ttf", 48);
-    ScoreEntry entries[MAX_SCORES];
-    int n = load_scores(entries, MAX_SCORES);
-    qsort(entries, n, sizeof(ScoreEntry), cmp_score);
+    LeaderEntry entries[10];
+    int n = leaderboard_top(&leaderboard, entries, 10);
     SDL_BlitSurface(board, NULL, screen, NULL);
     SDL_BlitSurface(title, NULL, screen, &(SDL_Rect){SCREEN_WIDTH/2-title->w/2, 40, title->w, title->h});
     SDL_Color white = {255,255,255};
@@ -301,256 +265,242 @@ void show_best_scores() {
 
 void run_game() {
     SDL_Surface* screen = SDL_SetVideoMode(SCREEN_WIDTH, SCREEN_HEIGHT, 32, SDL_HWSURFACE);
-    SDL_Surface* bg = IMG_Load("jeu/background.png");
+    // The level background is streamed from a tile pack, cut on first run if missing
+    TiledBackground bg;
+    int bg_ok = tiles_open(&bg, "jeu/background.tiles") == 0;
+    if (!bg_ok && tiles_build("jeu/background.png", "jeu/background.tiles") == 0) {
+        bg_ok = tiles_open(&bg, "jeu/background.tiles") == 0;
+    }
     SDL_Surface* collisionmap = IMG_Load("jeu/collisionmap.png");
     SDL_Surface* walk_sheet = IMG_Load("jeu/joueur/walk.png");
     SDL_Surface* attack_sheet = IMG_Load("jeu/joueur/attack.png");
+    AnimSet clips;
+    int clips_ok = sim_load_clips(&clips) == 0;
     TTF_Init();
     TTF_Font* font = TTF_OpenFont("font.ttf", 64);
-    if (!bg || !collisionmap || !walk_sheet || !attack_sheet || !font) {
+    if (!bg_ok || !clips_ok || !collisionmap || !walk_sheet || !attack_sheet || !font) {
         fprintf(stderr, "Error loading game assets\n");
+        if (bg_ok) tiles_close(&bg);
         return;
     }
-    srand(time(NULL));
-    Player player = {100, GROUND_Y - PLAYER_H, 0, 0, 1, 1, 0, 0, 0};
-    int attack_anim_counter = 0;
+    // Sheet and frame width behind each clip
+    SDL_Surface* clip_sheet[CLIP_COUNT] = {walk_sheet, walk_sheet, attack_sheet};
+    const int clip_w[CLIP_COUNT] = {WALK_W, WALK_W, ATTACK_W};
+    GameSim sim;
+    sim_init(&sim, bg.width, (Uint32)time(NULL));
+    Player* player = &sim.player;
+    Uint32 step_time = SDL_GetTicks();
     int running = 1;
-    int frame = 0;
-    int camera_x = 0;
-    int camera_y = 0;
-    int level = 1;
-    int timer = 15;
-    int fade = 0;
-    int fade_in = 0;
-    int fade_done = 0;
-    int score = 0;
-    Uint32 last_time = SDL_GetTicks();
-    Enemy enemies[MAX_ENEMIES] = {0};
-    int enemy_count = 3;
-    int max_enemies = 3;
-    for (int i = 0; i < enemy_count; ++i) spawn_enemy(&enemies[i], 1, camera_x);
+    ScrollLayer scroll;
+    scroll_init(&scroll, SCREEN_WIDTH, SCREEN_HEIGHT);
+    RenderQueue rq;
+    rq_init(&rq);
+    rq_set_mark(&rq, mark_scroll_dirty, &scroll);
+    // Rewind while Backspace is held, quick-save with F5 and quick-load with F9
+    size_t snap_size = sizeof(GameSnapshot) + sim.sectors.count * sizeof(Sector);
+    Uint8* snap = calloc(1, snap_size);
+    Rewind history;
+    int history_ok = snap && rewind_init(&history, snap_size, REWIND_BUDGET, REWIND_INTERVAL) == 0;
+    // Per-frame surfaces: borrowed while drawing, all handed back at the top of the next frame
+    ScratchArena scratch;
+    scratch_init(&scratch);
+    TextSlot timer_text = {0}, score_text = {0}, fade_text = {0};
     SDL_Event e;
+    input_start();
+    // F12 saves a screenshot, F11 starts and stops recording
+    Capture capture;
+    int capture_ok = capture_open(&capture, SCREEN_WIDTH, SCREEN_HEIGHT) == 0;
+    if (capture_ok && record_game) capture_video(&capture, 1);
     while (running) {
+        scratch_reset(&scratch);
+        int quick_save = 0, quick_load = 0;
         Uint32 now = SDL_GetTicks();
-        if (now - last_time >= 1000 && fade == 0) {
-            timer--;
-            last_time = now;
-        }
         while (SDL_PollEvent(&e)) {
             if (e.type == SDL_QUIT) running = 0;
+        }
+        // Keys come from the timestamped queue: everything up to the start of
+        // this tick, in the order it happened
+        Uint32 tick = input_now();
+        InputEvent input;
+        while (input_poll(&input, tick)) {
+            e = input.event;
+            input_probe_mark(input.time);
             if (e.type == SDL_KEYDOWN) {
-                if (e.key.keysym.sym == SDLK_LEFT) {
-                    player.vx = -PLAYER_SPEED;
-                    player.facing_right = 0;
-                }
-                if (e.key.keysym.sym == SDLK_RIGHT) {
-                    player.vx = PLAYER_SPEED;
-                    player.facing_right = 1;
-                }
-                if (e.key.keysym.sym == SDLK_UP && player.on_ground) {
-                    player.vy = JUMP_VELOCITY;
-                    player.on_ground = 0;
-                }
-                if (e.key.keysym.sym == SDLK_k && !player.attacking) {
-                    player.attacking = 1;
-                    player.attack_frame = 0;
-                }
+                if (e.key.keysym.sym == SDLK_LEFT) sim_act(&sim, ACT_LEFT);
+                if (e.key.keysym.sym == SDLK_RIGHT) sim_act(&sim, ACT_RIGHT);
+                if (e.key.keysym.sym == SDLK_UP) sim_act(&sim, ACT_JUMP);
+                if (e.key.keysym.sym == SDLK_k) sim_act(&sim, ACT_ATTACK);
+                if (e.key.keysym.sym == SDLK_F5) quick_save = 1;
+                if (e.key.keysym.sym == SDLK_F9) quick_load = 1;
+                if (e.key.keysym.sym == SDLK_F12 && capture_ok) capture_still(&capture);
+                if (e.key.keysym.sym == SDLK_F11 && capture_ok) capture_video(&capture, !capture.recording);
             }
             if (e.type == SDL_KEYUP) {
-                if (e.key.keysym.sym == SDLK_LEFT || e.key.keysym.sym == SDLK_RIGHT) {
-                    player.vx = 0;
-                }
-            }
-        }
-        // Physics
-        player.x += player.vx;
-        player.y += player.vy;
-        if (!player.on_ground) player.vy += GRAVITY;
-        if (player.y + PLAYER_H >= GROUND_Y) {
-            player.y = GROUND_Y - PLAYER_H;
-            player.vy = 0;
-            player.on_ground = 1;
-        }
-        // Camera
-        camera_x = player.x + (player.attacking ? ATTACK_W / 2 : WALK_W / 2) - SCREEN_WIDTH / 2;
-        if (camera_x < 0) camera_x = 0;
-        int bg_max_x = bg->w - SCREEN_WIDTH;
-        if (camera_x > bg_max_x) camera_x = bg_max_x;
-        camera_y = GROUND_Y + PLAYER_H - SCREEN_HEIGHT;
-        if (camera_y < 0) camera_y = 0;
-        // Animation
-        if (player.attacking) {
-            attack_anim_counter++;
-            if (attack_anim_counter >= 6) {
-                player.attack_frame++;
-                attack_anim_counter = 0;
+                if (e.key.keysym.sym == SDLK_LEFT || e.key.keysym.sym == SDLK_RIGHT) sim_act(&sim, ACT_STOP);
             }
-            if (player.attack_frame >= ATTACK_FRAMES) player.attacking = 0;
-        } else if (player.vx != 0 && player.on_ground) {
-            if (frame % 6 == 0) player.walk_frame = (player.walk_frame + 1) % WALK_FRAMES;
-        } else {
-            player.walk_frame = 0;
         }
-        // Attack collision
-        if (player.attacking && player.attack_frame == 2) {
-            for (int i = 0; i < enemy_count; ++i) {
-                if (!enemies[i].alive) continue;
-                int px = player.x + (player.facing_right ? WALK_W : -40);
-                SDL_Rect atk = {px, player.y, player.facing_right ? ATTACK_W : 40, PLAYER_H};
-                SDL_Rect er = {enemies[i].x, enemies[i].y, enemies[i].w, enemies[i].h};
-                if (atk.x < er.x + er.w && atk.x + atk.w > er.x && atk.y < er.y + er.h && atk.y + atk.h > er.y) {
-                    enemies[i].hp--;
-                    if (enemies[i].hp <= 0) {
-                        enemies[i].alive = 0;
-                        score++;
-                    }
-                }
+        // History: record the state this frame starts from, or go back to an older one
+        if (history_ok) {
+            GameSnapshot* gs = (GameSnapshot*)snap;
+            gs->sim = sim;
+            memcpy(snap + sizeof(GameSnapshot), sim.sectors.sectors, sim.sectors.count * sizeof(Sector));
+            int restore = 0;
+            if (SDL_GetKeyState(NULL)[SDLK_BACKSPACE]) restore = rewind_back(&history, 1, snap) > 0;
+            else if (quick_load) restore = rewind_load_mark(&history, snap) == 0;
+            else rewind_tick(&history, snap);
+            if (quick_save) rewind_mark(&history, snap);
+            if (restore) {
+                // The sector array stays where it is, only its contents come back
+                Sector* live = sim.sectors.sectors;
+                sim = gs->sim;
+                sim.sectors.sectors = live;
+                memcpy(live, snap + sizeof(GameSnapshot), sim.sectors.count * sizeof(Sector));
+                scroll_mark(&scroll, NULL);
             }
         }
+        // Simulation, by the time this frame took
+        sim_step(&sim, &clips, now - step_time);
+        step_time = now;
+        int player_x = FIX_TO_INT(player->x);
+        int player_y = FIX_TO_INT(player->y);
         // Draw
-        SDL_Rect bg_src = {camera_x, camera_y, SCREEN_WIDTH, SCREEN_HEIGHT};
-        SDL_BlitSurface(bg, &bg_src, screen, NULL);
+        // Background: only new columns come from the tiles, only covered areas are restored
+        scroll_update(&scroll, &bg, sim.camera_x, sim.camera_y);
+        scroll_present(&scroll, screen);
+        // World sprites go through the render queue, which culls against the camera
+        rq_begin(&rq, sim.camera_x, sim.camera_y, SCREEN_WIDTH, SCREEN_HEIGHT);
         // Draw enemies
-        for (int i = 0; i < enemy_count; ++i) {
-            if (!enemies[i].alive) continue;
-            SDL_Rect er = {enemies[i].x - camera_x, enemies[i].y - camera_y, enemies[i].w, enemies[i].h};
-            SDL_FillRect(screen, &er, SDL_MapRGB(screen->format, level == 1 ? 255 : 0, 0, 0));
+        Uint32 enemy_color = SDL_MapRGB(screen->format, sim.level == 1 ? 255 : 0, 0, 0);
+        for (int i = 0; i < sim.enemy_count; ++i) {
+            const Enemy* en = &sim.enemies[i];
+            if (!en->alive) continue;
+            rq_fill(&rq, LAYER_ENEMIES, en->x, en->y, en->w, en->h, enemy_color);
         }
         // Draw player
-        SDL_Rect src, dst;
-        dst.x = (player.x - camera_x);
-        dst.y = player.y - camera_y;
-        SDL_Surface* current_sheet = player.attacking ? attack_sheet : walk_sheet;
-        int current_frame = player.attacking ? player.attack_frame : player.walk_frame;
-        if (player.attacking) {
-            dst.w = ATTACK_W;
-            dst.h = PLAYER_H;
-            src.x = current_frame * ATTACK_W;
-            src.y = 0;
-            src.w = ATTACK_W;
-            src.h = PLAYER_H;
+        SDL_Surface* current_sheet = clip_sheet[player->anim.clip];
+        int frame_w = clip_w[player->anim.clip];
+        SDL_Rect src = {anim_frame(&clips, &player->anim) * frame_w, 0, frame_w, PLAYER_H};
+        if (player->facing_right) {
+            rq_blit(&rq, LAYER_PLAYER, current_sheet, &src, player_x, player_y);
         } else {
-            dst.w = WALK_W;
-            dst.h = PLAYER_H;
-            src.x = current_frame * WALK_W;
-            src.y = 0;
-            src.w = WALK_W;
-            src.h = PLAYER_H;
-        }
-        if (player.facing_right) {
-            SDL_BlitSurface(current_sheet, &src, screen, &dst);
-        } else {
-            SDL_Surface* flipped = SDL_CreateRGBSurface(SDL_SWSURFACE, src.w, src.h, 32,
-                current_sheet->format->Rmask, current_sheet->format->Gmask, current_sheet->format->Bmask, current_sheet->format->Amask);
-            SDL_LockSurface(current_sheet);
-            SDL_LockSurface(flipped);
-            for (int y = 0; y < src.h; ++y) {
-                for (int x = 0; x < src.w; ++x) {
-                    Uint32 pixel = ((Uint32*)(((Uint8*)current_sheet->pixels) + (src.y + y) * current_sheet->pitch))[src.x + x];
-                    ((Uint32*)((Uint8*)flipped->pixels + y * flipped->pitch))[src.w - 1 - x] = pixel;
+            ScratchSurface flipped = scratch_get(&scratch, src.w, src.h, current_sheet->format);
+            if (flipped.surf) {
+                SDL_LockSurface(current_sheet);
+                SDL_LockSurface(flipped.surf);
+                for (int y = 0; y < src.h; ++y) {
+                    for (int x = 0; x < src.w; ++x) {
+                        Uint32 pixel = ((Uint32*)(((Uint8*)current_sheet->pixels) + (src.y + y) * current_sheet->pitch))[src.x + x];
+                        ((Uint32*)((Uint8*)flipped.surf->pixels + y * flipped.surf->pitch))[src.w - 1 - x] = pixel;
+                    }
                 }
+                SDL_UnlockSurface(current_sheet);
+                SDL_UnlockSurface(flipped.surf);
+                rq_blit(&rq, LAYER_PLAYER, flipped.surf, &flipped.area, player_x, player_y);
             }
-            SDL_UnlockSurface(current_sheet);
-            SDL_UnlockSurface(flipped);
-            SDL_BlitSurface(flipped, NULL, screen, &dst);
-            SDL_FreeSurface(flipped);
         }
+        rq_flush(&rq, screen);
         // Draw timer
         char tstr[16];
-        sprintf(tstr, "%02d", timer);
+        sprintf(tstr, "%02d", sim.timer);
         SDL_Color white = {255, 255, 255};
-        SDL_Surface* ttxt = TTF_RenderText_Solid(font, tstr, white);
+        SDL_Surface* ttxt = text_slot_render(&timer_text, font, tstr, white);
         SDL_Rect tdst = {20, 20, ttxt->w, ttxt->h};
         SDL_BlitSurface(ttxt, NULL, screen, &tdst);
-        SDL_FreeSurface(ttxt);
+        scroll_mark(&scroll, &tdst);
         // Draw score
         char score_str[32];
-        sprintf(score_str, "Score: %d", score);
-        SDL_Surface* stxt = TTF_RenderText_Solid(font, score_str, white);
+        sprintf(score_str, "Score: %d", sim.score);
+        SDL_Surface* stxt = text_slot_render(&score_text, font, score_str, white);
         SDL_Rect sdst = {20, 80, stxt->w, stxt->h};
-        SDL_BlitSurface(stxt, NULL, screen, &sdst);        SDL_FreeSurface(stxt);
-        // Fade and level transition from level 1 to level 2
-        if (level == 1 && timer <= 0 && fade < 255 && !fade_done) fade += 5;
-        if (level == 1 && fade >= 255 && !fade_done) {
-            fade_done = 1;
-            SDL_Delay(1000);
-            fade_in = 1;
-            timer = 30;
-            level = 2;
-            for (int i = 0; i < MAX_ENEMIES; ++i) enemies[i].alive = 0;
-            spawn_enemy(&enemies[0], 2, camera_x);
-            enemy_count = 1;
+        SDL_BlitSurface(stxt, NULL, screen, &sdst);
+        scroll_mark(&scroll, &sdst);
+        // Fade between levels
+        if (sim.fade_in || sim.fade > 0) {
+            scroll_mark(&scroll, NULL);
+            draw_fade_and_text(screen, &scratch, &fade_text, sim.fade, "LEVEL 2", (SDL_Color){255, 0, 0}, font);
         }
-        if (fade_in) {
-            draw_fade_and_text(screen, fade, "LEVEL 2", (SDL_Color){255, 0, 0}, font);
-            if (fade > 0) fade -= 5;
-            else {
-                fade_in = 0;
-                fade = 0;
-                fade_done = 0;
-            }
-        } else if (fade > 0) {
-            draw_fade_and_text(screen, fade, "LEVEL 2", (SDL_Color){255, 0, 0}, font);
-        }
-        // Level 1 logic: respawn red rectangles up to max_enemies
-        if (level == 1 && timer > 0) {
-            int alive = 0;
-            for (int i = 0; i < enemy_count; ++i) {
-                if (enemies[i].alive) alive++;
-            }
-            for (int i = 0; i < enemy_count && alive < max_enemies; ++i) {
-                if (!enemies[i].alive) {
-                    spawn_enemy(&enemies[i], 1, camera_x);
-                    alive++;
-                }
-            }
+        // The simulation already counted the pause; hold it on screen too
+        if (sim.hold_ms) {
+            SDL_Delay(sim.hold_ms);
+            sim.hold_ms = 0;
+            step_time = SDL_GetTicks();
         }
-        // Level 2 logic
-        if (level == 2 && timer > 0) {
-            int alive = 0;
-            for (int i = 0; i < enemy_count; ++i) {
-                if (enemies[i].alive) alive++;
-            }
-            for (int i = 0; i < enemy_count && alive < max_enemies; ++i) {
-                if (!enemies[i].alive) {
-                    spawn_enemy(&enemies[i], 2, camera_x);
-                    alive++;
-                }
-            }
-        }        // End level 2 when timer runs out
-        if (level == 2 && timer <= 0) {
-            if (!fade_done) {
-                if (fade < 255) {
-                    fade += 5;
-                } else {
-                    fade_done = 1;
-                    SDL_Delay(1000);
-                    show_score_menu(score);
-                    show_best_scores();
-                    running = 0;
-                    continue;
-                }
-            }
+        if (sim.over) {
+            // The name prompt reads keys through SDL_PollEvent again
+            input_stop();
+            show_score_menu(sim.score);
+            show_best_scores();
+            running = 0;
+            continue;
         }
         SDL_Flip(screen);
+        input_probe_flip();
+        if (capture_ok) capture_frame(&capture, screen);
         SDL_Delay(16);
-        frame++;
     }
-    SDL_FreeSurface(bg);
+    input_stop();
+    input_report(stdout);
+    if (capture_ok) {
+        capture_close(&capture);
+        capture_report(&capture, stdout);
+    }
+    scroll_report(&scroll, stdout);
+    scroll_free(&scroll);
+    tiles_report(&bg, stdout);
+    tiles_close(&bg);
     SDL_FreeSurface(collisionmap);
     SDL_FreeSurface(walk_sheet);
     SDL_FreeSurface(attack_sheet);
+    sim_free(&sim);
+    rq_report(&rq, stdout);
+    rq_free(&rq);
+    scratch_report(&scratch, stdout);
+    scratch_free(&scratch);
+    if (history_ok) {
+        rewind_report(&history, stdout);
+        rewind_free(&history);
+    }
+    free(snap);
+    text_slot_free(&timer_text);
+    text_slot_free(&score_text);
+    text_slot_free(&fade_text);
     TTF_CloseFont(font);
     TTF_Quit();
 }
 
-int main(int argc, char* argv[]) {    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+int main(int argc, char* argv[]) {
+    // --batch N [--seed S] [--bot random|chase]: headless balancing runs, no window
+    int batch_runs = 0;
+    Uint32 batch_seed = (Uint32)time(NULL);
+    BotKind batch_bot = BOT_CHASE;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) batch_runs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) batch_seed = (Uint32)strtoul(argv[++i], NULL, 0);
+        else if (strcmp(argv[i], "--bot") == 0 && i + 1 < argc) batch_bot = strcmp(argv[++i], "random") == 0 ? BOT_RANDOM : BOT_CHASE;
+    }
+    if (batch_runs > 0) {
+        if (SDL_Init(0) < 0) {
+            fprintf(stderr, "SDL init error: %s\n", SDL_GetError());
+            return 1;
+        }
+        int rc = run_batch(batch_runs, batch_seed, batch_bot, stdout);
+        SDL_Quit();
+        return rc == 0 ? 0 : 1;
+    }
+    if (input_sdl_init(SDL_INIT_VIDEO) < 0) {
         fprintf(stderr, "SDL init error: %s\n", SDL_GetError());
         return 1;
     }
     SDL_EnableUNICODE(1);  // Enable Unicode text input
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--record") == 0) record_game = 1;
+    }
     atexit(SDL_Quit);
+    if (leaderboard_open(&leaderboard, "score.txt", "score.idx") != 0) {
+        fprintf(stderr, "Scores will not be saved\n");
+    }
     handle_menu();
     run_game();
+    leaderboard_close(&leaderboard);
     return 0;
 }
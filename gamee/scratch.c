@@ -0,0 +1,93 @@
+// scratch.c
+// Scratch surface pool and cached text for the game loop
+#include "scratch.h"
+#include <string.h>
+
+void scratch_init(ScratchArena* a) {
+    memset(a, 0, sizeof(*a));
+}
+
+void scratch_free(ScratchArena* a) {
+    for (int i = 0; i < SCRATCH_SLOTS; ++i) {
+        if (a->slots[i].surf) SDL_FreeSurface(a->slots[i].surf);
+    }
+    memset(a->slots, 0, sizeof(a->slots));
+}
+
+static int same_format(const SDL_PixelFormat* f, const SDL_PixelFormat* like) {
+    return f->BitsPerPixel == like->BitsPerPixel && f->Rmask == like->Rmask &&
+           f->Gmask == like->Gmask && f->Bmask == like->Bmask && f->Amask == like->Amask;
+}
+
+ScratchSurface scratch_get(ScratchArena* a, int w, int h, const SDL_PixelFormat* like) {
+    ScratchSurface out = {NULL, {0, 0, w, h}};
+    ScratchSlot* best = NULL;
+    ScratchSlot* empty = NULL;
+    ScratchSlot* spare = NULL;
+    a->borrows++;
+
+    // Smallest free surface that fits; otherwise an empty slot, otherwise a
+    // free surface of the wrong size or format to replace
+    for (int i = 0; i < SCRATCH_SLOTS; ++i) {
+        ScratchSlot* s = &a->slots[i];
+        if (s->in_use) continue;
+        if (!s->surf) {
+            if (!empty) empty = s;
+            continue;
+        }
+        if (s->surf->w >= w && s->surf->h >= h && same_format(s->surf->format, like)) {
+            if (!best || s->surf->w * s->surf->h < best->surf->w * best->surf->h) best = s;
+        } else if (!spare) {
+            spare = s;
+        }
+    }
+
+    if (!best) {
+        best = empty ? empty : spare;
+        if (!best) return out;
+        if (best->surf) SDL_FreeSurface(best->surf);
+        int bw = (w + SCRATCH_BUCKET - 1) / SCRATCH_BUCKET * SCRATCH_BUCKET;
+        int bh = (h + SCRATCH_BUCKET - 1) / SCRATCH_BUCKET * SCRATCH_BUCKET;
+        best->surf = SDL_CreateRGBSurface(SDL_SWSURFACE, bw, bh, like->BitsPerPixel,
+            like->Rmask, like->Gmask, like->Bmask, like->Amask);
+        a->creates++;
+        if (!best->surf) return out;
+    }
+
+    // Hand it out in the state of a fresh surface
+    SDL_SetAlpha(best->surf, like->Amask ? SDL_SRCALPHA : 0, SDL_ALPHA_OPAQUE);
+    SDL_SetColorKey(best->surf, 0, 0);
+    best->in_use = 1;
+    out.surf = best->surf;
+    return out;
+}
+
+void scratch_reset(ScratchArena* a) {
+    for (int i = 0; i < SCRATCH_SLOTS; ++i) a->slots[i].in_use = 0;
+}
+
+void scratch_report(const ScratchArena* a, FILE* out) {
+    if (!a->borrows) return;
+    fprintf(out, "scratch surfaces: %lu borrows, %lu allocations\n", a->borrows, a->creates);
+}
+
+SDL_Surface* text_slot_render(TextSlot* slot, TTF_Font* font, const char* text, SDL_Color color) {
+    if (slot->surf && slot->font == font && strcmp(slot->text, text) == 0 &&
+        slot->color.r == color.r && slot->color.g == color.g && slot->color.b == color.b) {
+        return slot->surf;
+    }
+    if (slot->surf) SDL_FreeSurface(slot->surf);
+    // TTF refuses empty strings; keep an empty slot instead
+    slot->surf = text[0] ? TTF_RenderText_Solid(font, text, color) : NULL;
+    slot->font = font;
+    slot->color = color;
+    // Text that does not fit the key is simply rendered again next time
+    if (strlen(text) < TEXT_SLOT_LEN) strcpy(slot->text, text);
+    else slot->text[0] = '\0';
+    return slot->surf;
+}
+
+void text_slot_free(TextSlot* slot) {
+    if (slot->surf) SDL_FreeSurface(slot->surf);
+    memset(slot, 0, sizeof(*slot));
+}
@@ -0,0 +1,51 @@
+// scratch.h
+// Per-frame scratch surfaces for run_game() and the score screens: short-lived
+// surfaces are borrowed from a pool and handed back by one reset at frame end,
+// and text is only re-rendered when its string changes
+#ifndef SCRATCH_H
+#define SCRATCH_H
+
+#include <SDL/SDL.h>
+#include <SDL/SDL_ttf.h>
+#include <stdio.h>
+
+#define SCRATCH_SLOTS 8
+#define SCRATCH_BUCKET 64       // pooled sizes are rounded up to this
+#define TEXT_SLOT_LEN 64
+
+typedef struct {
+    SDL_Surface* surf;          // bucket sized, only `area` is valid
+    int in_use;
+} ScratchSlot;
+
+typedef struct {
+    ScratchSlot slots[SCRATCH_SLOTS];
+    unsigned long borrows;
+    unsigned long creates;      // borrows that had to allocate
+} ScratchArena;
+
+// Borrowed until scratch_reset(); draw and blit through `area`
+typedef struct {
+    SDL_Surface* surf;
+    SDL_Rect area;
+} ScratchSurface;
+
+void scratch_init(ScratchArena* a);
+void scratch_free(ScratchArena* a);
+// Matches `like`'s pixel format; surf is NULL when every slot is taken
+ScratchSurface scratch_get(ScratchArena* a, int w, int h, const SDL_PixelFormat* like);
+void scratch_reset(ScratchArena* a);
+void scratch_report(const ScratchArena* a, FILE* out);
+
+typedef struct {
+    SDL_Surface* surf;
+    TTF_Font* font;
+    SDL_Color color;
+    char text[TEXT_SLOT_LEN];
+} TextSlot;
+
+// Owned by the slot, valid until the next call with different text or colour
+SDL_Surface* text_slot_render(TextSlot* slot, TTF_Font* font, const char* text, SDL_Color color);
+void text_slot_free(TextSlot* slot);
+
+#endif
@@ -0,0 +1,108 @@
+// scroll.c
+// Ring-buffered background: strips in, restore rectangles out
+#include "scroll.h"
+#include <string.h>
+
+static int wrap(int x, int w) {
+    return ((x % w) + w) % w;
+}
+
+int scroll_init(ScrollLayer* sl, int w, int h) {
+    memset(sl, 0, sizeof(*sl));
+    // Same layout as the tiles, so strips and restores are plain copies
+    sl->ring = SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0);
+    return sl->ring ? 0 : -1;
+}
+
+void scroll_free(ScrollLayer* sl) {
+    if (sl->ring) SDL_FreeSurface(sl->ring);
+    sl->ring = NULL;
+}
+
+// Draws world columns [world_x, world_x + len) into their ring slots
+static void draw_span(ScrollLayer* sl, TiledBackground* bg, int world_x, int len, int camera_y) {
+    int w = sl->ring->w, h = sl->ring->h;
+    int start = wrap(world_x, w);
+    int first = len < w - start ? len : w - start;
+    tiles_draw_area(bg, sl->ring, world_x, camera_y, first, h, start, 0);
+    if (len > first) tiles_draw_area(bg, sl->ring, world_x + first, camera_y, len - first, h, 0, 0);
+    sl->ring_pixels += (unsigned long long)len * h;
+}
+
+void scroll_update(ScrollLayer* sl, TiledBackground* bg, int camera_x, int camera_y) {
+    int w = sl->ring->w, h = sl->ring->h;
+    int dx = camera_x - sl->camera_x;
+    if (!sl->valid || camera_y != sl->camera_y || dx <= -w || dx >= w) {
+        draw_span(sl, bg, camera_x, w, camera_y);
+    } else if (dx > 0) {
+        draw_span(sl, bg, sl->camera_x + w, dx, camera_y);
+    } else if (dx < 0) {
+        draw_span(sl, bg, camera_x, -dx, camera_y);
+    }
+    sl->camera_x = camera_x;
+    sl->camera_y = camera_y;
+    sl->valid = 1;
+    tiles_prefetch(bg, camera_x, camera_y, w, h);
+}
+
+// Copies screen area (sx, sy, cw, ch) of the current view from the ring
+static void copy_span(ScrollLayer* sl, SDL_Surface* screen, int sx, int sy, int cw, int ch) {
+    int w = sl->ring->w;
+    int col = wrap(sl->camera_x + sx, w);
+    int first = cw < w - col ? cw : w - col;
+    SDL_Rect src = {col, sy, first, ch};
+    SDL_Rect dst = {sx, sy, first, ch};
+    SDL_BlitSurface(sl->ring, &src, screen, &dst);
+    if (cw > first) {
+        SDL_Rect src2 = {0, sy, cw - first, ch};
+        SDL_Rect dst2 = {sx + first, sy, cw - first, ch};
+        SDL_BlitSurface(sl->ring, &src2, screen, &dst2);
+    }
+    sl->screen_pixels += (unsigned long long)cw * ch;
+}
+
+void scroll_present(ScrollLayer* sl, SDL_Surface* screen) {
+    int w = sl->ring->w, h = sl->ring->h;
+    // A double-buffered screen does not keep last frame, so restores can't work
+    int full = !sl->screen_valid || sl->dirty_full || (screen->flags & SDL_DOUBLEBUF) ||
+               sl->presented_x != sl->camera_x || sl->presented_y != sl->camera_y;
+    if (full) {
+        copy_span(sl, screen, 0, 0, w, h);
+    } else {
+        for (int i = 0; i < sl->dirty_count; ++i) {
+            SDL_Rect* d = &sl->dirty[i];
+            copy_span(sl, screen, d->x, d->y, d->w, d->h);
+        }
+    }
+    sl->dirty_count = 0;
+    sl->dirty_full = 0;
+    sl->screen_valid = 1;
+    sl->presented_x = sl->camera_x;
+    sl->presented_y = sl->camera_y;
+    sl->frames++;
+}
+
+void scroll_mark(ScrollLayer* sl, const SDL_Rect* r) {
+    if (!r) {
+        sl->dirty_full = 1;
+        return;
+    }
+    int x0 = r->x < 0 ? 0 : r->x;
+    int y0 = r->y < 0 ? 0 : r->y;
+    int x1 = r->x + r->w > sl->ring->w ? sl->ring->w : r->x + r->w;
+    int y1 = r->y + r->h > sl->ring->h ? sl->ring->h : r->y + r->h;
+    if (x1 <= x0 || y1 <= y0) return;
+    if (sl->dirty_count == SCROLL_MAX_DIRTY) {
+        sl->dirty_full = 1;
+        return;
+    }
+    SDL_Rect clipped = {x0, y0, x1 - x0, y1 - y0};
+    sl->dirty[sl->dirty_count++] = clipped;
+}
+
+void scroll_report(const ScrollLayer* sl, FILE* out) {
+    if (!sl->frames) return;
+    unsigned long long view = (unsigned long long)sl->ring->w * sl->ring->h;
+    fprintf(out, "scroll layer: %lu frames, %.0f px/frame drawn from tiles, %.0f px/frame copied (full view %llu)\n",
+            sl->frames, (double)sl->ring_pixels / sl->frames, (double)sl->screen_pixels / sl->frames, view);
+}
@@ -0,0 +1,34 @@
+// scroll.h
+// Wrap-around background layer for run_game(): a camera step only redraws the
+// newly exposed columns, and a still camera only restores what sprites covered
+#ifndef SCROLL_H
+#define SCROLL_H
+
+#include <SDL/SDL.h>
+#include <stdio.h>
+#include "tiles.h"
+
+#define SCROLL_MAX_DIRTY 64
+
+typedef struct {
+    SDL_Surface* ring;          // view sized, world column x lives at x % ring->w
+    int camera_x, camera_y;     // view currently held by the ring
+    int valid;
+    int presented_x, presented_y;
+    int screen_valid;           // screen holds the background at presented_x/y
+    SDL_Rect dirty[SCROLL_MAX_DIRTY];   // screen areas drawn over since the last present
+    int dirty_count;
+    int dirty_full;
+    unsigned long frames;
+    unsigned long long ring_pixels;     // background pixels drawn into the ring
+    unsigned long long screen_pixels;   // background pixels copied to the screen
+} ScrollLayer;
+
+int scroll_init(ScrollLayer* sl, int w, int h);
+void scroll_free(ScrollLayer* sl);
+void scroll_update(ScrollLayer* sl, TiledBackground* bg, int camera_x, int camera_y);
+void scroll_present(ScrollLayer* sl, SDL_Surface* screen);
+void scroll_mark(ScrollLayer* sl, const SDL_Rect* r);   // NULL marks the whole screen
+void scroll_report(const ScrollLayer* sl, FILE* out);
+
+#endif
@@ -0,0 +1,97 @@
+// sector.c
+// Sector activation: sleeping sectors keep their enemies as packed records
+#include "sector.h"
+#include <stdlib.h>
+#include <string.h>
+
+int sectors_init(SectorMap* map, int world_w) {
+    map->count = (world_w + SECTOR_WIDTH - 1) / SECTOR_WIDTH;
+    if (map->count < 1) map->count = 1;
+    map->sectors = calloc(map->count, sizeof(Sector));
+    map->parked = 0;
+    return map->sectors ? 0 : -1;
+}
+
+void sectors_free(SectorMap* map) {
+    free(map->sectors);
+    map->sectors = NULL;
+    map->count = 0;
+    map->parked = 0;
+}
+
+void sectors_clear(SectorMap* map) {
+    for (int s = 0; s < map->count; ++s) map->sectors[s].packed_count = 0;
+    map->parked = 0;
+}
+
+int sector_of(const SectorMap* map, int x) {
+    int s = x / SECTOR_WIDTH;
+    if (s < 0) s = 0;
+    if (s >= map->count) s = map->count - 1;
+    return s;
+}
+
+static void pack_sector(SectorMap* map, int s, Enemy* enemies, int enemy_count) {
+    Sector* sec = &map->sectors[s];
+    for (int i = 0; i < enemy_count; ++i) {
+        Enemy* e = &enemies[i];
+        if (!e->alive || sector_of(map, e->x + e->w / 2) != s) continue;
+        if (sec->packed_count >= MAX_ENEMIES) break;
+        Uint8* p = sec->packed + sec->packed_count * PACKED_ENEMY_SIZE;
+        int dx = e->x - s * SECTOR_WIDTH;
+        p[0] = dx & 0xFF;
+        p[1] = (dx >> 8) & 0xFF;
+        p[2] = e->y & 0xFF;
+        p[3] = (e->y >> 8) & 0xFF;
+        p[4] = (Uint8)e->w;
+        p[5] = (Uint8)e->h;
+        p[6] = (Uint8)e->hp;
+        sec->packed_count++;
+        map->parked++;
+        e->alive = 0;
+    }
+}
+
+static void unpack_sector(SectorMap* map, int s, Enemy* enemies, int enemy_count) {
+    Sector* sec = &map->sectors[s];
+    int n = 0;
+    for (int i = 0; i < enemy_count && n < sec->packed_count; ++i) {
+        Enemy* e = &enemies[i];
+        if (e->alive) continue;
+        const Uint8* p = sec->packed + n * PACKED_ENEMY_SIZE;
+        e->x = s * SECTOR_WIDTH + (Sint16)(p[0] | (p[1] << 8));
+        e->y = (Sint16)(p[2] | (p[3] << 8));
+        e->w = p[4];
+        e->h = p[5];
+        e->hp = p[6];
+        e->alive = 1;
+        n++;
+    }
+    // Anything that found no free slot stays packed until next time
+    memmove(sec->packed, sec->packed + n * PACKED_ENEMY_SIZE, (sec->packed_count - n) * PACKED_ENEMY_SIZE);
+    sec->packed_count -= n;
+    map->parked -= n;
+}
+
+void sectors_update(SectorMap* map, int camera_x, Enemy* enemies, int enemy_count) {
+    int first = sector_of(map, camera_x);
+    int last = sector_of(map, camera_x + SCREEN_WIDTH - 1);
+    for (int s = 0; s < map->count; ++s) {
+        SectorState state = SECTOR_ASLEEP;
+        if (s >= first && s <= last) state = SECTOR_ACTIVE;
+        else if (s >= first - SECTOR_NEAR_RADIUS && s <= last + SECTOR_NEAR_RADIUS) state = SECTOR_NEAR;
+
+        SectorState old = map->sectors[s].state;
+        if (old != SECTOR_ASLEEP && state == SECTOR_ASLEEP) pack_sector(map, s, enemies, enemy_count);
+        else if (old == SECTOR_ASLEEP && state != SECTOR_ASLEEP) unpack_sector(map, s, enemies, enemy_count);
+        map->sectors[s].state = state;
+    }
+}
+
+int sector_tick_due(const SectorMap* map, int x, int frame) {
+    switch (map->sectors[sector_of(map, x)].state) {
+        case SECTOR_ACTIVE: return 1;
+        case SECTOR_NEAR: return frame % SECTOR_SLOW_TICK == 0;
+        default: return 0;
+    }
+}
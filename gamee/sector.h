@@ -0,0 +1,34 @@
+// sector.h
+// World sectors for run_game(): enemies far from the camera are packed away
+#ifndef SECTOR_H
+#define SECTOR_H
+
+#include "game.h"
+
+#define SECTOR_WIDTH 640
+#define SECTOR_NEAR_RADIUS 1   // sectors past the view that stay resident
+#define SECTOR_SLOW_TICK 4     // near sectors tick once every N frames
+#define PACKED_ENEMY_SIZE 7    // dx(2) y(2) w(1) h(1) hp(1)
+
+typedef enum { SECTOR_ASLEEP, SECTOR_NEAR, SECTOR_ACTIVE } SectorState;
+
+typedef struct {
+    SectorState state;
+    int packed_count;
+    Uint8 packed[MAX_ENEMIES * PACKED_ENEMY_SIZE];
+} Sector;
+
+typedef struct {
+    Sector* sectors;
+    int count;
+    int parked;   // enemies currently packed in sleeping sectors
+} SectorMap;
+
+int sectors_init(SectorMap* map, int world_w);
+void sectors_free(SectorMap* map);
+void sectors_clear(SectorMap* map);
+int sector_of(const SectorMap* map, int x);
+void sectors_update(SectorMap* map, int camera_x, Enemy* enemies, int enemy_count);
+int sector_tick_due(const SectorMap* map, int x, int frame);
+
+#endif
@@ -0,0 +1,177 @@
+// sim.c
+// run_game() rules. Spawns draw from the simulation's own RNG stream, so a
+// seed replays the same run whichever thread steps it.
+#include "sim.h"
+#include "jobs.h"
+#include <string.h>
+
+static void spawn_enemy(GameSim* s, Enemy* e, int hp) {
+    e->w = 60;
+    e->h = 80;
+    e->x = s->camera_x + 100 + rng_next(&s->rng) % (SCREEN_WIDTH - 200 - e->w);
+    e->y = GROUND_Y - e->h;
+    e->alive = 1;
+    e->hp = hp;
+}
+
+int sim_load_clips(AnimSet* clips) {
+    static const char* const clip_names[CLIP_COUNT] = {"stand", "walk", "attack"};
+    static const char* const event_names[EVENT_COUNT] = {"hit"};
+    if (anim_load(clips, "jeu/joueur/player.clips", clip_names, CLIP_COUNT, event_names, EVENT_COUNT) != 0) return -1;
+    if (anim_max_frame(clips, CLIP_STAND) >= WALK_FRAMES || anim_max_frame(clips, CLIP_WALK) >= WALK_FRAMES
+        || anim_max_frame(clips, CLIP_ATTACK) >= ATTACK_FRAMES) return -1;
+    return 0;
+}
+
+int sim_init(GameSim* s, int world_w, Uint32 seed) {
+    memset(s, 0, sizeof(*s));
+    s->rng = seed ? seed : 0x6D2B79F5u;
+    Player player = {INT_TO_FIX(100), INT_TO_FIX(GROUND_Y - PLAYER_H), 0, 0, 1, 1, 0, {0}};
+    s->player = player;
+    s->level = 1;
+    s->timer = LEVEL1_TIME;
+    s->enemy_count = LEVEL1_ENEMIES;
+    s->max_enemies = MAX_ALIVE;
+    s->world_w = world_w;
+    for (int i = 0; i < s->enemy_count; ++i) spawn_enemy(s, &s->enemies[i], LEVEL1_HP);
+    return sectors_init(&s->sectors, world_w);
+}
+
+void sim_free(GameSim* s) {
+    sectors_free(&s->sectors);
+}
+
+void sim_act(GameSim* s, int action) {
+    Player* p = &s->player;
+    switch (action) {
+    case ACT_LEFT:
+        p->vx = -INT_TO_FIX(PLAYER_SPEED);
+        p->facing_right = 0;
+        break;
+    case ACT_RIGHT:
+        p->vx = INT_TO_FIX(PLAYER_SPEED);
+        p->facing_right = 1;
+        break;
+    case ACT_STOP:
+        p->vx = 0;
+        break;
+    case ACT_JUMP:
+        if (p->on_ground) {
+            p->vy = INT_TO_FIX(JUMP_VELOCITY);
+            p->on_ground = 0;
+        }
+        break;
+    case ACT_ATTACK:
+        if (!p->attacking) {
+            p->attacking = 1;
+            anim_restart(&p->anim, CLIP_ATTACK);
+        }
+        break;
+    }
+}
+
+// Keeps `max_enemies` up at the given strength while the level runs
+static void respawn(GameSim* s, int hp) {
+    int alive = s->sectors.parked;
+    for (int i = 0; i < s->enemy_count; ++i) {
+        if (s->enemies[i].alive) alive++;
+    }
+    for (int i = 0; i < s->enemy_count && alive < s->max_enemies; ++i) {
+        if (!s->enemies[i].alive) {
+            spawn_enemy(s, &s->enemies[i], hp);
+            alive++;
+        }
+    }
+}
+
+void sim_step(GameSim* s, const AnimSet* clips, Uint32 dt_ms) {
+    Player* player = &s->player;
+    s->clock += dt_ms;
+    if (s->clock - s->last_time >= 1000 && s->fade == 0) {
+        s->timer--;
+        s->last_time = s->clock;
+    }
+    // Physics
+    player->x += player->vx;
+    player->y += player->vy;
+    if (!player->on_ground) player->vy += INT_TO_FIX(GRAVITY);
+    if (FIX_TO_INT(player->y) + PLAYER_H >= GROUND_Y) {
+        player->y = INT_TO_FIX(GROUND_Y - PLAYER_H);
+        player->vy = 0;
+        player->on_ground = 1;
+    }
+    int player_x = FIX_TO_INT(player->x);
+    int player_y = FIX_TO_INT(player->y);
+    // Camera
+    s->camera_x = player_x + (player->attacking ? ATTACK_W / 2 : WALK_W / 2) - SCREEN_WIDTH / 2;
+    if (s->camera_x < 0) s->camera_x = 0;
+    int bg_max_x = s->world_w - SCREEN_WIDTH;
+    if (s->camera_x > bg_max_x) s->camera_x = bg_max_x;
+    s->camera_y = GROUND_Y + PLAYER_H - SCREEN_HEIGHT;
+    if (s->camera_y < 0) s->camera_y = 0;
+    // Sectors: park enemies the camera left behind, wake the ones it reaches
+    sectors_update(&s->sectors, s->camera_x, s->enemies, s->enemy_count);
+    // Animation: advance by elapsed time, the attack clip ends the attack
+    if (!player->attacking) anim_play(&player->anim, player->vx != 0 && player->on_ground ? CLIP_WALK : CLIP_STAND);
+    anim_update(clips, &player->anim, 1, dt_ms);
+    if (player->attacking && player->anim.done) {
+        player->attacking = 0;
+        anim_play(&player->anim, player->vx != 0 && player->on_ground ? CLIP_WALK : CLIP_STAND);
+    }
+    // Attack collision, once per swing when the clip reaches its hit frame
+    if (player->anim.event == EVENT_HIT) {
+        for (int i = 0; i < s->enemy_count; ++i) {
+            Enemy* e = &s->enemies[i];
+            if (!e->alive) continue;
+            if (!sector_tick_due(&s->sectors, e->x + e->w / 2, s->frame)) continue;
+            int px = player_x + (player->facing_right ? WALK_W : -40);
+            WorldRect atk = {px, player_y, player->facing_right ? ATTACK_W : 40, PLAYER_H};
+            WorldRect er = {e->x, e->y, e->w, e->h};
+            if (world_overlap(atk, er)) {
+                e->hp--;
+                if (e->hp <= 0) {
+                    e->alive = 0;
+                    s->score++;
+                }
+            }
+        }
+    }
+    // Fade and level transition from level 1 to level 2
+    if (s->level == 1 && s->timer <= 0 && s->fade < 255 && !s->fade_done) s->fade += FADE_STEP;
+    if (s->level == 1 && s->fade >= 255 && !s->fade_done) {
+        s->fade_done = 1;
+        s->fade_in = 1;
+        s->level1_score = s->score;
+        s->timer = LEVEL2_TIME;
+        s->level = 2;
+        for (int i = 0; i < MAX_ENEMIES; ++i) s->enemies[i].alive = 0;
+        sectors_clear(&s->sectors);
+        spawn_enemy(s, &s->enemies[0], LEVEL2_HP);
+        s->enemy_count = LEVEL2_ENEMIES;
+        s->hold_ms = LEVEL_PAUSE_MS;
+        s->clock += LEVEL_PAUSE_MS;
+    }
+    if (s->fade_in) {
+        if (s->fade > 0) s->fade -= FADE_STEP;
+        else {
+            s->fade_in = 0;
+            s->fade = 0;
+            s->fade_done = 0;
+        }
+    }
+    // Respawns while the clock runs
+    if (s->level == 1 && s->timer > 0) respawn(s, LEVEL1_HP);
+    if (s->level == 2 && s->timer > 0) respawn(s, LEVEL2_HP);
+    // End level 2 when timer runs out
+    if (s->level == 2 && s->timer <= 0 && !s->fade_done) {
+        if (s->fade < 255) {
+            s->fade += FADE_STEP;
+        } else {
+            s->fade_done = 1;
+            s->over = 1;
+            s->hold_ms = LEVEL_PAUSE_MS;
+            s->clock += LEVEL_PAUSE_MS;
+        }
+    }
+    s->frame++;
+}
@@ -0,0 +1,50 @@
+// sim.h
+// Simulation of run_game(), apart from drawing: the game loop and headless
+// batch runs step the same state
+#ifndef SIM_H
+#define SIM_H
+
+#include "game.h"
+#include "sector.h"
+
+// Level tuning
+#define LEVEL1_TIME 15          // seconds
+#define LEVEL2_TIME 30
+#define LEVEL1_HP 1
+#define LEVEL2_HP 2
+#define LEVEL1_ENEMIES 3
+#define LEVEL2_ENEMIES 1
+#define MAX_ALIVE 3             // respawns keep this many enemies up
+#define FADE_STEP 5
+#define LEVEL_PAUSE_MS 1000     // black screen between levels and at the end
+
+// Player actions, from the keyboard or from a bot
+enum { ACT_LEFT, ACT_RIGHT, ACT_STOP, ACT_JUMP, ACT_ATTACK };
+
+typedef struct {
+    Player player;
+    Enemy enemies[MAX_ENEMIES];
+    int enemy_count, max_enemies;
+    int timer, score, level;
+    int fade, fade_in, fade_done;
+    int frame;
+    int camera_x, camera_y;
+    int world_w;
+    Uint32 clock;           // simulated ms
+    Uint32 last_time;       // clock when the timer last ticked
+    Uint32 rng;
+    int level1_score;       // score when level 1 ended
+    int over;               // level 2 has faded out
+    Uint32 hold_ms;         // the loop should hold the current frame this long
+    SectorMap sectors;      // contents live outside the struct
+} GameSim;
+
+// Player clips, checked against the sprite sheets' frame counts
+int  sim_load_clips(AnimSet* clips);
+int  sim_init(GameSim* s, int world_w, Uint32 seed);
+void sim_free(GameSim* s);
+void sim_act(GameSim* s, int action);
+// One frame: timers, physics, camera, sectors, animation, combat, levels
+void sim_step(GameSim* s, const AnimSet* clips, Uint32 dt_ms);
+
+#endif
@@ -0,0 +1,11 @@
+// tilepack.c
+// Cuts a level image into the tile pack streamed by tiles.c
+#include "tiles.h"
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s image.png out.tiles\n", argv[0]);
+        return 1;
+    }
+    return tiles_build(argv[1], argv[2]) == 0 ? 0 : 1;
+}
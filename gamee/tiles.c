@@ -0,0 +1,354 @@
+// tiles.c
+// Tile pack writer/reader and the LRU tile cache with scroll-ahead prefetch
+#include "tiles.h"
+#include <SDL/SDL_image.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+// Pack layout (native endianness, it is a local build artifact):
+//   "BGT1", endian mark, width, height, tile size, cols, rows,
+//   offsets[cols*rows], sizes[cols*rows], zlib-compressed tiles.
+// Every tile is stored as a full TILE_SIZE square of XRGB8888 so it inflates
+// straight into a cache surface; edge tiles are zero padded.
+#define PACK_MAGIC "BGT1"
+#define PACK_ENDIAN 0x01020304u
+#define PACK_HEADER_WORDS 6
+#define TILE_BYTES (TILE_SIZE * TILE_SIZE * 4)
+
+#define RMASK 0x00FF0000
+#define GMASK 0x0000FF00
+#define BMASK 0x000000FF
+
+static SDL_Surface* create_tile_surface(void) {
+    return SDL_CreateRGBSurface(SDL_SWSURFACE, TILE_SIZE, TILE_SIZE, 32, RMASK, GMASK, BMASK, 0);
+}
+
+int tiles_build(const char* image_path, const char* pack_path) {
+    SDL_Surface* image = IMG_Load(image_path);
+    if (!image) {
+        fprintf(stderr, "Error loading %s: %s\n", image_path, IMG_GetError());
+        return -1;
+    }
+    SDL_Surface* rgb = SDL_CreateRGBSurface(SDL_SWSURFACE, image->w, image->h, 32, RMASK, GMASK, BMASK, 0);
+    SDL_SetAlpha(image, 0, SDL_ALPHA_OPAQUE);
+    SDL_BlitSurface(image, NULL, rgb, NULL);
+    SDL_FreeSurface(image);
+
+    Uint32 header[PACK_HEADER_WORDS] = {PACK_ENDIAN, rgb->w, rgb->h, TILE_SIZE,
+        (rgb->w + TILE_SIZE - 1) / TILE_SIZE, (rgb->h + TILE_SIZE - 1) / TILE_SIZE};
+    int count = header[4] * header[5];
+    Uint32* offsets = calloc(count, sizeof(Uint32));
+    Uint32* sizes = calloc(count, sizeof(Uint32));
+    Uint8* raw = malloc(TILE_BYTES);
+    uLong bound = compressBound(TILE_BYTES);
+    Uint8* z = malloc(bound);
+
+    // Write next to the target and rename, so a crash never leaves half a pack
+    char tmp_path[256];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", pack_path);
+    FILE* f = fopen(tmp_path, "wb");
+    int ok = f && offsets && sizes && raw && z;
+    if (ok) {
+        fwrite(PACK_MAGIC, 1, 4, f);
+        fwrite(header, sizeof(Uint32), PACK_HEADER_WORDS, f);
+        fwrite(offsets, sizeof(Uint32), count, f);
+        fwrite(sizes, sizeof(Uint32), count, f);
+        SDL_LockSurface(rgb);
+        for (int t = 0; t < count && ok; ++t) {
+            int tx = (t % header[4]) * TILE_SIZE;
+            int ty = (t / header[4]) * TILE_SIZE;
+            int tw = rgb->w - tx < TILE_SIZE ? rgb->w - tx : TILE_SIZE;
+            int th = rgb->h - ty < TILE_SIZE ? rgb->h - ty : TILE_SIZE;
+            memset(raw, 0, TILE_BYTES);
+            for (int y = 0; y < th; ++y) {
+                memcpy(raw + y * TILE_SIZE * 4, (Uint8*)rgb->pixels + (ty + y) * rgb->pitch + tx * 4, tw * 4);
+            }
+            uLongf zlen = bound;
+            ok = compress2(z, &zlen, raw, TILE_BYTES, Z_DEFAULT_COMPRESSION) == Z_OK;
+            offsets[t] = (Uint32)ftell(f);
+            sizes[t] = (Uint32)zlen;
+            ok = ok && fwrite(z, 1, zlen, f) == zlen;
+        }
+        SDL_UnlockSurface(rgb);
+        fseek(f, 4 + PACK_HEADER_WORDS * sizeof(Uint32), SEEK_SET);
+        fwrite(offsets, sizeof(Uint32), count, f);
+        fwrite(sizes, sizeof(Uint32), count, f);
+    }
+    if (f && fclose(f) != 0) ok = 0;
+    if (ok) ok = rename(tmp_path, pack_path) == 0;
+    if (!ok) {
+        fprintf(stderr, "Error writing tile pack %s\n", pack_path);
+        remove(tmp_path);
+    }
+    free(offsets);
+    free(sizes);
+    free(raw);
+    free(z);
+    SDL_FreeSurface(rgb);
+    return ok ? 0 : -1;
+}
+
+static int decode_tile(TiledBackground* tb, FILE* f, Uint8* zbuf, int tile, SDL_Surface* dst) {
+    if (fseek(f, tb->offsets[tile], SEEK_SET) != 0) return -1;
+    if (fread(zbuf, 1, tb->sizes[tile], f) != tb->sizes[tile]) return -1;
+    if (dst->pitch != TILE_SIZE * 4) return -1;
+    uLongf len = TILE_BYTES;
+    SDL_LockSurface(dst);
+    int rc = uncompress(dst->pixels, &len, zbuf, tb->sizes[tile]);
+    SDL_UnlockSurface(dst);
+    return (rc == Z_OK && len == TILE_BYTES) ? 0 : -1;
+}
+
+static int prefetch_main(void* data) {
+    TiledBackground* tb = data;
+    SDL_mutexP(tb->lock);
+    while (!tb->quit) {
+        if (tb->queue_count == 0) {
+            SDL_CondWait(tb->cond, tb->lock);
+            continue;
+        }
+        int tile = tb->queue[tb->queue_head];
+        tb->queue_head = (tb->queue_head + 1) % TILE_PREFETCH_QUEUE;
+        tb->queue_count--;
+
+        PrefetchBuf* buf = NULL;
+        for (int i = 0; i < TILE_PREFETCH_BUFS && !buf; ++i) {
+            if (tb->prefetch[i].state == PREFETCH_FREE) buf = &tb->prefetch[i];
+        }
+        if (!buf) continue;  // all busy: the main thread will load it on demand
+        buf->state = PREFETCH_LOADING;
+        buf->tile = tile;
+
+        SDL_mutexV(tb->lock);
+        int ok = decode_tile(tb, tb->prefetch_file, tb->prefetch_zbuf, tile, buf->surface) == 0;
+        SDL_mutexP(tb->lock);
+        buf->state = ok ? PREFETCH_READY : PREFETCH_FREE;
+    }
+    SDL_mutexV(tb->lock);
+    return 0;
+}
+
+int tiles_open(TiledBackground* tb, const char* pack_path) {
+    memset(tb, 0, sizeof(*tb));
+    tb->file = fopen(pack_path, "rb");
+    if (!tb->file) return -1;
+
+    char magic[4];
+    Uint32 header[PACK_HEADER_WORDS];
+    if (fread(magic, 1, 4, tb->file) != 4 || memcmp(magic, PACK_MAGIC, 4) != 0 ||
+        fread(header, sizeof(Uint32), PACK_HEADER_WORDS, tb->file) != PACK_HEADER_WORDS ||
+        header[0] != PACK_ENDIAN || header[3] != TILE_SIZE) {
+        fprintf(stderr, "Tile pack %s is invalid or outdated\n", pack_path);
+        tiles_close(tb);
+        return -1;
+    }
+    tb->width = header[1];
+    tb->height = header[2];
+    tb->cols = header[4];
+    tb->rows = header[5];
+
+    int count = tb->cols * tb->rows;
+    tb->offsets = malloc(count * sizeof(Uint32));
+    tb->sizes = malloc(count * sizeof(Uint32));
+    if (!tb->offsets || !tb->sizes ||
+        fread(tb->offsets, sizeof(Uint32), count, tb->file) != (size_t)count ||
+        fread(tb->sizes, sizeof(Uint32), count, tb->file) != (size_t)count) {
+        tiles_close(tb);
+        return -1;
+    }
+    for (int t = 0; t < count; ++t) {
+        if (tb->sizes[t] > tb->max_size) tb->max_size = tb->sizes[t];
+    }
+    tb->zbuf = malloc(tb->max_size);
+    tb->prefetch_zbuf = malloc(tb->max_size);
+    tb->prefetch_file = fopen(pack_path, "rb");
+    if (!tb->zbuf || !tb->prefetch_zbuf || !tb->prefetch_file) {
+        tiles_close(tb);
+        return -1;
+    }
+
+    for (int i = 0; i < TILE_CACHE_SLOTS; ++i) {
+        tb->slots[i].tile = -1;
+        tb->slots[i].surface = create_tile_surface();
+        if (!tb->slots[i].surface) {
+            tiles_close(tb);
+            return -1;
+        }
+    }
+    for (int i = 0; i < TILE_PREFETCH_BUFS; ++i) {
+        tb->prefetch[i].tile = -1;
+        tb->prefetch[i].state = PREFETCH_FREE;
+        tb->prefetch[i].surface = create_tile_surface();
+        if (!tb->prefetch[i].surface) {
+            tiles_close(tb);
+            return -1;
+        }
+    }
+
+    tb->lock = SDL_CreateMutex();
+    tb->cond = SDL_CreateCond();
+    if (tb->lock && tb->cond) tb->thread = SDL_CreateThread(prefetch_main, tb);
+    // Without the worker every tile is simply decoded on demand
+    if (!tb->thread) fprintf(stderr, "Tile prefetch disabled: %s\n", SDL_GetError());
+    return 0;
+}
+
+void tiles_close(TiledBackground* tb) {
+    if (tb->thread) {
+        SDL_mutexP(tb->lock);
+        tb->quit = 1;
+        SDL_CondSignal(tb->cond);
+        SDL_mutexV(tb->lock);
+        SDL_WaitThread(tb->thread, NULL);
+        tb->thread = NULL;
+    }
+    if (tb->cond) SDL_DestroyCond(tb->cond);
+    if (tb->lock) SDL_DestroyMutex(tb->lock);
+    tb->cond = NULL;
+    tb->lock = NULL;
+    for (int i = 0; i < TILE_CACHE_SLOTS; ++i) {
+        if (tb->slots[i].surface) SDL_FreeSurface(tb->slots[i].surface);
+        tb->slots[i].surface = NULL;
+    }
+    for (int i = 0; i < TILE_PREFETCH_BUFS; ++i) {
+        if (tb->prefetch[i].surface) SDL_FreeSurface(tb->prefetch[i].surface);
+        tb->prefetch[i].surface = NULL;
+    }
+    if (tb->file) fclose(tb->file);
+    if (tb->prefetch_file) fclose(tb->prefetch_file);
+    tb->file = tb->prefetch_file = NULL;
+    free(tb->offsets);
+    free(tb->sizes);
+    free(tb->zbuf);
+    free(tb->prefetch_zbuf);
+    tb->offsets = tb->sizes = NULL;
+    tb->zbuf = tb->prefetch_zbuf = NULL;
+}
+
+static int tile_resident(const TiledBackground* tb, int tile) {
+    for (int i = 0; i < TILE_CACHE_SLOTS; ++i) {
+        if (tb->slots[i].tile == tile) return 1;
+    }
+    return 0;
+}
+
+static SDL_Surface* get_tile(TiledBackground* tb, int tile) {
+    TileSlot* victim = &tb->slots[0];
+    for (int i = 0; i < TILE_CACHE_SLOTS; ++i) {
+        TileSlot* slot = &tb->slots[i];
+        if (slot->tile == tile) {
+            slot->last_used = tb->clock;
+            tb->hits++;
+            return slot->surface;
+        }
+        if (victim->tile != -1 && (slot->tile == -1 || slot->last_used < victim->last_used)) victim = slot;
+    }
+
+    // Take the worker's copy if it already decoded this tile
+    int adopted = 0;
+    if (tb->thread) {
+        SDL_mutexP(tb->lock);
+        for (int i = 0; i < TILE_PREFETCH_BUFS && !adopted; ++i) {
+            PrefetchBuf* buf = &tb->prefetch[i];
+            if (buf->state == PREFETCH_READY && buf->tile == tile) {
+                SDL_Surface* swap = victim->surface;
+                victim->surface = buf->surface;
+                buf->surface = swap;
+                buf->state = PREFETCH_FREE;
+                adopted = 1;
+            }
+        }
+        SDL_mutexV(tb->lock);
+    }
+    if (adopted) {
+        tb->prefetch_hits++;
+    } else {
+        tb->misses++;
+        if (decode_tile(tb, tb->file, tb->zbuf, tile, victim->surface) != 0) {
+            victim->tile = -1;
+            return NULL;
+        }
+    }
+    victim->tile = tile;
+    victim->last_used = tb->clock;
+    return victim->surface;
+}
+
+static void prefetch_ahead(TiledBackground* tb, int c0, int c1, int r0, int r1, int dir) {
+    SDL_mutexP(tb->lock);
+    // Drop decoded tiles the camera has moved away from
+    for (int i = 0; i < TILE_PREFETCH_BUFS; ++i) {
+        PrefetchBuf* buf = &tb->prefetch[i];
+        int col = buf->tile % tb->cols;
+        if (buf->state == PREFETCH_READY && (col < c0 - 1 || col > c1 + 1)) buf->state = PREFETCH_FREE;
+    }
+    int col = dir > 0 ? c1 + 1 : c0 - 1;
+    if (dir != 0 && col >= 0 && col < tb->cols) {
+        for (int r = r0; r <= r1; ++r) {
+            int tile = r * tb->cols + col;
+            int known = tile_resident(tb, tile);
+            for (int i = 0; i < TILE_PREFETCH_BUFS && !known; ++i) {
+                known = tb->prefetch[i].state != PREFETCH_FREE && tb->prefetch[i].tile == tile;
+            }
+            for (int i = 0; i < tb->queue_count && !known; ++i) {
+                known = tb->queue[(tb->queue_head + i) % TILE_PREFETCH_QUEUE] == tile;
+            }
+            if (known || tb->queue_count == TILE_PREFETCH_QUEUE) continue;
+            tb->queue[(tb->queue_head + tb->queue_count) % TILE_PREFETCH_QUEUE] = tile;
+            tb->queue_count++;
+        }
+        SDL_CondSignal(tb->cond);
+    }
+    SDL_mutexV(tb->lock);
+}
+
+void tiles_draw_area(TiledBackground* tb, SDL_Surface* dst, int world_x, int world_y, int w, int h, int dst_x, int dst_y) {
+    tb->clock++;
+    int c0 = world_x / TILE_SIZE;
+    int c1 = (world_x + w - 1) / TILE_SIZE;
+    int r0 = world_y / TILE_SIZE;
+    int r1 = (world_y + h - 1) / TILE_SIZE;
+    if (c1 >= tb->cols) c1 = tb->cols - 1;
+    if (r1 >= tb->rows) r1 = tb->rows - 1;
+
+    SDL_Rect clip = {dst_x, dst_y, w, h};
+    SDL_SetClipRect(dst, &clip);
+    for (int r = r0; r <= r1; ++r) {
+        for (int c = c0; c <= c1; ++c) {
+            SDL_Surface* tile = get_tile(tb, r * tb->cols + c);
+            if (!tile) continue;
+            int tx = c * TILE_SIZE, ty = r * TILE_SIZE;
+            SDL_Rect src = {0, 0, tb->width - tx < TILE_SIZE ? tb->width - tx : TILE_SIZE,
+                            tb->height - ty < TILE_SIZE ? tb->height - ty : TILE_SIZE};
+            SDL_Rect out = {tx - world_x + dst_x, ty - world_y + dst_y, src.w, src.h};
+            SDL_BlitSurface(tile, &src, dst, &out);
+        }
+    }
+    SDL_SetClipRect(dst, NULL);
+}
+
+void tiles_prefetch(TiledBackground* tb, int camera_x, int camera_y, int view_w, int view_h) {
+    if (tb->thread) {
+        int c0 = camera_x / TILE_SIZE;
+        int c1 = (camera_x + view_w - 1) / TILE_SIZE;
+        int r0 = camera_y / TILE_SIZE;
+        int r1 = (camera_y + view_h - 1) / TILE_SIZE;
+        if (c1 >= tb->cols) c1 = tb->cols - 1;
+        if (r1 >= tb->rows) r1 = tb->rows - 1;
+        int dir = (camera_x > tb->last_camera_x) - (camera_x < tb->last_camera_x);
+        prefetch_ahead(tb, c0, c1, r0, r1, dir);
+    }
+    tb->last_camera_x = camera_x;
+}
+
+void tiles_draw(TiledBackground* tb, SDL_Surface* screen, int camera_x, int camera_y) {
+    tiles_draw_area(tb, screen, camera_x, camera_y, screen->w, screen->h, 0, 0);
+    tiles_prefetch(tb, camera_x, camera_y, screen->w, screen->h);
+}
+
+void tiles_report(const TiledBackground* tb, FILE* out) {
+    fprintf(out, "background tiles: %dx%d, %lu hits, %lu misses, %lu prefetched, %d KB resident\n",
+            tb->cols, tb->rows, tb->hits, tb->misses, tb->prefetch_hits,
+            (TILE_CACHE_SLOTS + TILE_PREFETCH_BUFS) * TILE_BYTES / 1024);
+}
@@ -0,0 +1,65 @@
+// tiles.h
+// Streamed, tiled background: the level image lives in a tile pack on disk
+// and only tiles near the camera are decoded, through a fixed-size LRU cache.
+#ifndef TILES_H
+#define TILES_H
+
+#include <SDL/SDL.h>
+#include <stdio.h>
+
+#define TILE_SIZE 256
+#define TILE_CACHE_SLOTS 32    // a 1280x720 view touches at most 6x4 tiles
+#define TILE_PREFETCH_BUFS 8
+#define TILE_PREFETCH_QUEUE 16
+
+typedef struct {
+    int tile;              // -1 when empty
+    SDL_Surface* surface;  // TILE_SIZE x TILE_SIZE, reused across tiles
+    Uint32 last_used;
+} TileSlot;
+
+enum { PREFETCH_FREE, PREFETCH_LOADING, PREFETCH_READY };
+
+typedef struct {
+    int tile;
+    int state;
+    SDL_Surface* surface;
+} PrefetchBuf;
+
+typedef struct {
+    FILE* file;                // main thread handle
+    FILE* prefetch_file;       // worker thread handle
+    int width, height;
+    int cols, rows;
+    Uint32* offsets;
+    Uint32* sizes;
+    Uint8* zbuf;               // scratch for compressed tiles, main thread
+    Uint8* prefetch_zbuf;      // same, worker thread
+    Uint32 max_size;
+
+    TileSlot slots[TILE_CACHE_SLOTS];
+    Uint32 clock;
+    int last_camera_x;
+
+    PrefetchBuf prefetch[TILE_PREFETCH_BUFS];
+    int queue[TILE_PREFETCH_QUEUE];
+    int queue_head, queue_count;
+    SDL_Thread* thread;
+    SDL_mutex* lock;
+    SDL_cond* cond;
+    int quit;
+
+    unsigned long hits, misses, prefetch_hits;
+} TiledBackground;
+
+int tiles_build(const char* image_path, const char* pack_path);
+int tiles_open(TiledBackground* tb, const char* pack_path);
+void tiles_close(TiledBackground* tb);
+void tiles_draw(TiledBackground* tb, SDL_Surface* screen, int camera_x, int camera_y);
+// Draws world area (world_x, world_y, w, h) at (dst_x, dst_y) in dst, clipped to that area
+void tiles_draw_area(TiledBackground* tb, SDL_Surface* dst, int world_x, int world_y, int w, int h, int dst_x, int dst_y);
+// Queues the next column in the scroll direction for the prefetch worker
+void tiles_prefetch(TiledBackground* tb, int camera_x, int camera_y, int view_w, int view_h);
+void tiles_report(const TiledBackground* tb, FILE* out);
+
+#endif
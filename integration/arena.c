@@ -0,0 +1,301 @@
+#include "arena.h"
+#include "jobs.h"
+#include <stdlib.h>
+#include <time.h>
+
+bool checkCollision(WorldRect a, WorldRect b) {
+    return world_overlap(a, b);
+}
+
+void updateEnemyRange(void *data, int begin, int end) {
+    EnemyUpdate *u = data;
+    Enemies *e = u->enemies;
+
+    for (int i = begin; i < end; i++) {
+        AnimState *a = &e->anim[i];
+
+        // Turning and hurt play once, then fall back to idle
+        if (a->done && (a->clip == CLIP_TURN || a->clip == CLIP_HURT)) anim_play(a, CLIP_IDLE);
+
+        if (a->clip == CLIP_IDLE && (rng_next(&e->rng[i]) % 100 < 1)) {
+            anim_restart(a, CLIP_TURN);
+            e->moveDirection[i] *= -1;
+        }
+
+        if (a->clip != CLIP_TURN && !e->isDying[i]) {
+            e->pos[i].x += e->moveDirection[i] * u->moveDistance;
+
+            // Check collision with barrier for enemies
+            if (checkCollision(e->pos[i], u->barrierPos)) {
+                e->moveDirection[i] *= -1;
+                e->pos[i].x += e->moveDirection[i] * u->moveDistance * 2; // Push back
+            }
+
+            if (e->pos[i].x < 0 || e->pos[i].x > u->worldWidth - u->enemyWidth)
+                e->moveDirection[i] *= -1;
+        }
+
+        if (e->health[i] <= 0 && !e->isDying[i]) {
+            e->isDying[i] = true;
+            anim_restart(a, CLIP_DEATH);
+        }
+    }
+}
+
+void arena_init(ArenaSim *a, const ArenaLayout *layout, int players, Uint32 seed) {
+    ArenaSim empty = {0};
+    *a = empty;
+    a->players = players < 1 ? 1 : players > ARENA_PLAYERS ? ARENA_PLAYERS : players;
+    for (int p = 0; p < a->players; p++) {
+        a->player[p] = layout->player;
+        a->player[p].x += p * 2 * layout->player.w;
+    }
+    a->barrier = layout->barrier;
+    a->barrierDirection = 1;
+    for (int i = 0; i < MAX_OBSTACLES; i++) {
+        a->obstaclePos[i] = layout->obstacles[i];
+        a->obstacleActive[i] = true;
+    }
+    a->worldW = layout->worldW;
+    a->worldH = layout->worldH;
+    a->enemyW = layout->enemyW;
+    a->enemyH = layout->enemyH;
+
+    // Original enemy positions (100,210) and (300,210), then every 200px
+    Enemies *e = &a->enemies;
+    for (int i = 0; i < ENEMY_COUNT; i++) {
+        e->pos[i].x = 100 + i * 200;
+        e->pos[i].y = 820 - a->enemyH;  // Adjusted for sprite height
+        e->pos[i].w = a->enemyW;
+        e->pos[i].h = a->enemyH;
+        e->moveDirection[i] = (i % 2 == 0) ? 1 : -1;
+        e->health[i] = ENEMY_MAX_HEALTH;
+        e->rng[i] = rng_seed(seed, i);
+    }
+}
+
+void arena_step(ArenaSim *a, const ArenaInput *in, const AnimSet *clips, Uint32 dtMs, bool parallel) {
+    a->clock += dtMs;
+
+    // Move the barrier up and down
+    a->barrier.y += BARRIER_SPEED * a->barrierDirection;
+
+    // Reverse direction when barrier reaches top or bottom
+    if (a->barrier.y <= 0) {
+        a->barrier.y = 0;
+        a->barrierDirection = 1; // Start descending
+    } else if (a->barrier.y + a->barrier.h >= a->worldH) {
+        a->barrier.y = a->worldH - a->barrier.h;
+        a->barrierDirection = -1; // Start ascending
+    }
+
+    Enemies *e = &a->enemies;
+    for (int p = 0; p < a->players; p++) {
+        WorldRect *pos = &a->player[p];
+
+        // Only horizontal movement for player
+        if (in[p].left) pos->x -= PLAYER_SPEED;
+        if (in[p].right) pos->x += PLAYER_SPEED;
+
+        // Check collision with barrier (prevent passing through)
+        if (checkCollision(*pos, a->barrier)) {
+            // Push player left or right based on which side they're approaching from
+            if (pos->x + pos->w/2 < a->barrier.x + a->barrier.w/2) {
+                pos->x = a->barrier.x - pos->w;
+            } else {
+                pos->x = a->barrier.x + a->barrier.w;
+            }
+        }
+
+        // Attack on key down, again only once it was released
+        if ((in[p].attack || in[p].attackTapped) && !a->isAttacking[p]) {
+            a->isAttacking[p] = true;
+
+            for (int i = 0; i < ENEMY_COUNT; i++) {
+                WorldRect enemyRect = {e->pos[i].x, e->pos[i].y, a->enemyW, a->enemyH};
+                if (checkCollision(enemyRect, *pos)) {
+                    if (e->health[i] > 0 && !e->isDying[i]) {
+                        e->health[i]--;
+                        if (e->health[i] < 0) e->health[i] = 0;
+                        anim_restart(&e->anim[i], CLIP_HURT);
+                        a->hits++;
+                    }
+                }
+            }
+        }
+
+        if (!in[p].attack) {
+            a->isAttacking[p] = false;
+        }
+    }
+
+    // Every enemy animation advances by the elapsed time in one pass
+    anim_update(clips, e->anim, ENEMY_COUNT, dtMs);
+
+    EnemyUpdate enemyUpdate = {e, a->barrier, a->worldW, a->enemyW, ENEMY_SPEED};
+    if (parallel) jobs_parallel_for(ENEMY_COUNT, ENEMY_GRAIN, updateEnemyRange, &enemyUpdate);
+    else updateEnemyRange(&enemyUpdate, 0, ENEMY_COUNT);
+
+    // Obstacles are picked up by walking into them
+    for (int p = 0; p < a->players; p++) {
+        for (int i = 0; i < MAX_OBSTACLES; i++) {
+            if (a->obstacleActive[i] && checkCollision(a->player[p], a->obstaclePos[i])) {
+                a->obstacleActive[i] = false;
+                a->obstaclesTaken++;
+            }
+        }
+    }
+
+    if (!a->clearedAt) {
+        int down = 0;
+        for (int i = 0; i < ENEMY_COUNT; i++) down += e->isDying[i];
+        if (down == ENEMY_COUNT) a->clearedAt = a->clock;
+    }
+}
+
+// FNV-1a over the fields, not the struct, so padding never counts
+static Uint32 hashBytes(Uint32 h, const void *data, size_t size) {
+    const Uint8 *p = data;
+    for (size_t i = 0; i < size; i++) h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+Uint32 arena_checksum(const ArenaSim *a) {
+    const Enemies *e = &a->enemies;
+    Uint32 h = 2166136261u;
+    h = hashBytes(h, &a->players, sizeof(a->players));
+    h = hashBytes(h, a->player, sizeof(a->player));
+    h = hashBytes(h, a->isAttacking, sizeof(a->isAttacking));
+    h = hashBytes(h, &a->barrier, sizeof(a->barrier));
+    h = hashBytes(h, &a->barrierDirection, sizeof(a->barrierDirection));
+    for (int i = 0; i < MAX_OBSTACLES; i++) h = hashBytes(h, &a->obstacleActive[i], 1);
+    h = hashBytes(h, e->pos, sizeof(e->pos));
+    h = hashBytes(h, e->moveDirection, sizeof(e->moveDirection));
+    h = hashBytes(h, e->health, sizeof(e->health));
+    for (int i = 0; i < ENEMY_COUNT; i++) h = hashBytes(h, &e->isDying[i], 1);
+    h = hashBytes(h, e->anim, sizeof(e->anim));
+    h = hashBytes(h, e->rng, sizeof(e->rng));
+    h = hashBytes(h, &a->clock, sizeof(a->clock));
+    h = hashBytes(h, &a->clearedAt, sizeof(a->clearedAt));
+    h = hashBytes(h, &a->hits, sizeof(a->hits));
+    h = hashBytes(h, &a->obstaclesTaken, sizeof(a->obstaclesTaken));
+    return h;
+}
+
+Uint8 arena_input_pack(const ArenaInput *in) {
+    return (in->left ? ARENA_KEY_LEFT : 0) | (in->right ? ARENA_KEY_RIGHT : 0) |
+           (in->attack ? ARENA_KEY_ATTACK : 0) | (in->attackTapped ? ARENA_KEY_TAPPED : 0);
+}
+
+ArenaInput arena_input_unpack(Uint8 keys) {
+    ArenaInput in = {
+        (keys & ARENA_KEY_LEFT) != 0, (keys & ARENA_KEY_RIGHT) != 0,
+        (keys & ARENA_KEY_ATTACK) != 0, (keys & ARENA_KEY_TAPPED) != 0
+    };
+    return in;
+}
+
+// Batch runs
+
+typedef struct {
+    Uint32 clearedAt;
+    int hits, obstaclesTaken;
+} ArenaResult;
+
+typedef struct {
+    const ArenaLayout *layout;
+    const AnimSet *clips;
+    Uint32 seed;
+    ArenaResult *results;
+} ArenaBatch;
+
+// Walks to the nearest standing enemy and taps attack while touching it;
+// the key goes up every other frame so each tap lands
+static void botInput(const ArenaSim *a, ArenaInput *in) {
+    const Enemies *e = &a->enemies;
+    int px = a->player[0].x + a->player[0].w / 2;
+    int best = -1, bestD = 0;
+    for (int i = 0; i < ENEMY_COUNT; i++) {
+        if (e->isDying[i]) continue;
+        int d = e->pos[i].x + a->enemyW / 2 - px;
+        if (best < 0 || abs(d) < abs(bestD)) {
+            best = i;
+            bestD = d;
+        }
+    }
+    ArenaInput none = {0};
+    *in = none;
+    if (best < 0) return;
+    WorldRect enemyRect = {e->pos[best].x, e->pos[best].y, a->enemyW, a->enemyH};
+    if (checkCollision(enemyRect, a->player[0])) {
+        in->attack = !a->isAttacking[0];
+        in->attackTapped = in->attack;
+    } else {
+        in->left = bestD < 0;
+        in->right = bestD > 0;
+    }
+}
+
+static void batchRange(void *data, int begin, int end) {
+    ArenaBatch *b = data;
+    for (int run = begin; run < end; run++) {
+        ArenaSim a;
+        arena_init(&a, b->layout, 1, rng_seed(b->seed, run));
+        ArenaInput in;
+        while (!a.clearedAt && a.clock < ARENA_BATCH_LIMIT_MS) {
+            botInput(&a, &in);
+            arena_step(&a, &in, b->clips, ARENA_DT_MS, false);
+        }
+        b->results[run].clearedAt = a.clearedAt;
+        b->results[run].hits = a.hits;
+        b->results[run].obstaclesTaken = a.obstaclesTaken;
+    }
+}
+
+static int compareUint(const void *a, const void *b) {
+    Uint32 x = *(const Uint32 *)a, y = *(const Uint32 *)b;
+    return (x > y) - (x < y);
+}
+
+static double wallSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int arena_batch(const ArenaLayout *layout, const AnimSet *clips, int runs, Uint32 seed, FILE *out) {
+    if (runs <= 0) return -1;
+    ArenaResult *results = calloc(runs, sizeof(ArenaResult));
+    Uint32 *times = calloc(runs, sizeof(Uint32));
+    if (!results || !times) {
+        free(results);
+        free(times);
+        return -1;
+    }
+    ArenaBatch batch = {layout, clips, seed, results};
+    double start = wallSeconds();
+    jobs_parallel_for(runs, 1, batchRange, &batch);
+    double wall = wallSeconds() - start;
+
+    int cleared = 0;
+    double simSeconds = 0, hits = 0, taken = 0;
+    for (int i = 0; i < runs; i++) {
+        if (results[i].clearedAt) times[cleared++] = results[i].clearedAt;
+        simSeconds += (results[i].clearedAt ? results[i].clearedAt : ARENA_BATCH_LIMIT_MS) / 1000.0;
+        hits += results[i].hits;
+        taken += results[i].obstaclesTaken;
+    }
+    fprintf(out, "batch: %d runs (seed %u) on %d workers, %.0f simulated s in %.2f s wall, %.0fx real time\n",
+            runs, seed, jobs_worker_count(), simSeconds, wall, wall > 0 ? simSeconds / wall : 0);
+    fprintf(out, "batch: %d of %d cleared within %d s, %.1f hits and %.2f obstacles per run\n",
+            cleared, runs, ARENA_BATCH_LIMIT_MS / 1000, hits / runs, taken / runs);
+    if (cleared) {
+        qsort(times, cleared, sizeof(Uint32), compareUint);
+        fprintf(out, "batch: clear time min %.1f s, p10 %.1f s, p50 %.1f s, p90 %.1f s, max %.1f s\n",
+                times[0] / 1000.0, times[cleared / 10] / 1000.0, times[cleared / 2] / 1000.0,
+                times[cleared * 9 / 10] / 1000.0, times[cleared - 1] / 1000.0);
+    }
+    free(results);
+    free(times);
+    return 0;
+}
@@ -0,0 +1,96 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <SDL/SDL.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "world.h"
+#include "anim.h"
+
+#define ENEMY_MAX_HEALTH 6
+#define MAX_OBSTACLES 3
+#define ENEMY_COUNT 2
+#define ENEMY_GRAIN 64
+#define ARENA_PLAYERS 2
+#define PLAYER_SPEED 4
+#define BARRIER_SPEED 3
+#define ENEMY_SPEED 2
+#define ARENA_DT_MS 16              // fixed step for batch and netplay, as the game loop's delay
+#define ARENA_BATCH_LIMIT_MS 120000 // a batch run that has not cleared by then gives up
+
+// Enemy animation clips, in the order anim_load resolves them
+enum { CLIP_IDLE, CLIP_TURN, CLIP_HURT, CLIP_DEATH, CLIP_COUNT };
+
+// Enemy state, one array per field so update chunks stay contiguous
+typedef struct {
+    WorldRect pos[ENEMY_COUNT];
+    int moveDirection[ENEMY_COUNT];
+    int health[ENEMY_COUNT];
+    bool isDying[ENEMY_COUNT];
+    AnimState anim[ENEMY_COUNT];
+    Uint32 rng[ENEMY_COUNT];
+} Enemies;
+
+// Read-only frame inputs shared by every update chunk
+typedef struct {
+    Enemies *enemies;
+    WorldRect barrierPos;
+    int worldWidth;
+    int enemyWidth;
+    int moveDistance;
+} EnemyUpdate;
+
+// Sizes and starting places, which come from the loaded images. The batch
+// loads the same images once and shares this between every run.
+typedef struct {
+    int worldW, worldH;
+    WorldRect player;
+    WorldRect barrier;
+    WorldRect obstacles[MAX_OBSTACLES];
+    int enemyW, enemyH;
+} ArenaLayout;
+
+// Keys as of the step; a tap shorter than a frame still counts as an attack
+typedef struct {
+    bool left, right, attack, attackTapped;
+} ArenaInput;
+
+// One byte per player per frame, as netplay sends them
+enum { ARENA_KEY_LEFT = 1, ARENA_KEY_RIGHT = 2, ARENA_KEY_ATTACK = 4, ARENA_KEY_TAPPED = 8 };
+
+// Everything the arena rules touch, and nothing the screen needs
+typedef struct {
+    WorldRect player[ARENA_PLAYERS];
+    bool isAttacking[ARENA_PLAYERS];
+    int players;
+    WorldRect barrier;
+    int barrierDirection;       // 1 = descending, -1 = ascending
+    WorldRect obstaclePos[MAX_OBSTACLES];
+    bool obstacleActive[MAX_OBSTACLES];
+    Enemies enemies;
+    int worldW, worldH, enemyW, enemyH;
+    Uint32 clock;               // simulated ms
+    Uint32 clearedAt;           // clock when the last enemy went down, 0 before
+    int hits, obstaclesTaken;
+} ArenaSim;
+
+bool checkCollision(WorldRect a, WorldRect b);
+// Runs AI for enemies [begin, end) after their animations were advanced. Each
+// enemy only touches its own slots, so chunks can run on any worker in any order.
+void updateEnemyRange(void *data, int begin, int end);
+
+// The second player, if any, starts a little right of the first
+void arena_init(ArenaSim *a, const ArenaLayout *layout, int players, Uint32 seed);
+// One frame of play, one input per player. `parallel` spreads the enemies
+// over the job pool; a batch run already is a job and steps them inline.
+void arena_step(ArenaSim *a, const ArenaInput *in, const AnimSet *clips, Uint32 dtMs, bool parallel);
+// Hash of everything a step reads or changes, so two machines can compare
+// states. The layout sizes and obstacle places are left out: arena_init sets
+// them and nothing changes them.
+Uint32 arena_checksum(const ArenaSim *a);
+Uint8 arena_input_pack(const ArenaInput *in);
+ArenaInput arena_input_unpack(Uint8 keys);
+// Plays `runs` seeded arenas with a bot on the job pool and prints the aggregate
+int  arena_batch(const ArenaLayout *layout, const AnimSet *clips, int runs, Uint32 seed, FILE *out);
+
+#endif
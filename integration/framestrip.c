@@ -0,0 +1,230 @@
+#include "framestrip.h"
+#include "memtrack.h"
+#include <stdlib.h>
+#include <string.h>
+
+static SDL_Surface *blankLike(SDL_Surface *s) {
+    return SDL_CreateRGBSurface(SDL_SWSURFACE, s->w, s->h, 32, s->format->Rmask,
+                                s->format->Gmask, s->format->Bmask, s->format->Amask);
+}
+
+// Pixel rect of tile `t`; edge tiles are clipped to the frame and use only
+// the top-left part of their STRIP_TILE-wide buffer.
+static void tileRect(const FrameStrip *fs, int t, int w, int h, int *x, int *y, int *tw, int *th) {
+    *x = (t % fs->tilesX) * STRIP_TILE;
+    *y = (t / fs->tilesX) * STRIP_TILE;
+    *tw = w - *x < STRIP_TILE ? w - *x : STRIP_TILE;
+    *th = h - *y < STRIP_TILE ? h - *y : STRIP_TILE;
+}
+
+static int tileDiffers(SDL_Surface *a, SDL_Surface *b, int x, int y, int tw, int th) {
+    for (int r = 0; r < th; r++) {
+        Uint8 *pa = (Uint8 *)a->pixels + (y + r) * a->pitch + x * 4;
+        Uint8 *pb = (Uint8 *)b->pixels + (y + r) * b->pitch + x * 4;
+        if (memcmp(pa, pb, tw * 4) != 0) return 1;
+    }
+    return 0;
+}
+
+static int encode(FrameStrip *fs, SDL_Surface **frames) {
+    int w = frames[0]->w, h = frames[0]->h;
+    int tiles = fs->tilesX * fs->tilesY;
+
+    fs->key = frames[0];
+    frames[0] = NULL;
+    SDL_LockSurface(fs->key);
+
+    // Each frame diffs against the previous image; blank frames diff as if the
+    // previous image carried on, so the chain stays intact across them
+    SDL_Surface *prev = fs->key;
+    for (int i = 1; i < fs->count; i++) {
+        if (!frames[i]) {
+            fs->blank[i] = 1;
+            continue;
+        }
+        SDL_Surface *cur = frames[i];
+        StripDelta *d = &fs->deltas[i];
+        d->tiles = malloc(tiles * sizeof(Uint16));
+        d->pixels = malloc((size_t)tiles * STRIP_TILE * STRIP_TILE * sizeof(Uint32));
+        if (!d->tiles || !d->pixels) {
+            // Frames still in `frames` are freed by the caller; `prev` no longer is
+            if (prev != fs->key) SDL_FreeSurface(prev);
+            SDL_UnlockSurface(fs->key);
+            return -1;
+        }
+
+        SDL_LockSurface(cur);
+        for (int t = 0; t < tiles; t++) {
+            int x, y, tw, th;
+            tileRect(fs, t, w, h, &x, &y, &tw, &th);
+            if (!tileDiffers(prev, cur, x, y, tw, th)) continue;
+            Uint32 *dst = d->pixels + (size_t)d->tileCount * STRIP_TILE * STRIP_TILE;
+            for (int r = 0; r < th; r++) {
+                memcpy(dst + r * STRIP_TILE, (Uint8 *)cur->pixels + (y + r) * cur->pitch + x * 4, tw * 4);
+            }
+            d->tiles[d->tileCount++] = (Uint16)t;
+        }
+        SDL_UnlockSurface(cur);
+
+        // Trim to what was actually used
+        if (d->tileCount == 0) {
+            free(d->tiles);
+            free(d->pixels);
+            d->tiles = NULL;
+            d->pixels = NULL;
+        } else {
+            d->tiles = realloc(d->tiles, d->tileCount * sizeof(Uint16));
+            d->pixels = realloc(d->pixels, (size_t)d->tileCount * STRIP_TILE * STRIP_TILE * sizeof(Uint32));
+        }
+
+        if (prev != fs->key) SDL_FreeSurface(prev);
+        prev = cur;
+        frames[i] = NULL;
+    }
+    if (prev != fs->key) SDL_FreeSurface(prev);
+    SDL_UnlockSurface(fs->key);
+    return 0;
+}
+
+int strip_init(FrameStrip *fs, SDL_Surface **frames, int count, int delta) {
+    FrameStrip empty = {0};
+    *fs = empty;
+    fs->count = count;
+
+    // Delta mode needs a keyframe and frames that all share its size
+    if (delta && count > 1 && frames[0] && frames[0]->format->BitsPerPixel == 32) {
+        for (int i = 1; i < count; i++) {
+            if (frames[i] && (frames[i]->w != frames[0]->w || frames[i]->h != frames[0]->h ||
+                              frames[i]->format->BitsPerPixel != 32)) {
+                delta = 0;
+            }
+        }
+    } else {
+        delta = 0;
+    }
+
+    if (!delta) {
+        fs->frames = malloc(count * sizeof(SDL_Surface *));
+        if (!fs->frames) return -1;
+        memcpy(fs->frames, frames, count * sizeof(SDL_Surface *));
+        return 0;
+    }
+
+    fs->delta = 1;
+    fs->tilesX = (frames[0]->w + STRIP_TILE - 1) / STRIP_TILE;
+    fs->tilesY = (frames[0]->h + STRIP_TILE - 1) / STRIP_TILE;
+    fs->deltas = calloc(count, sizeof(StripDelta));
+    fs->blank = calloc(count, 1);
+    if (!fs->deltas || !fs->blank || encode(fs, frames) != 0) {
+        for (int i = 0; i < count; i++) {
+            if (frames[i]) SDL_FreeSurface(frames[i]);
+        }
+        strip_free(fs);
+        return -1;
+    }
+    return 0;
+}
+
+void strip_free(FrameStrip *fs) {
+    if (fs->frames) {
+        for (int i = 0; i < fs->count; i++) {
+            if (fs->frames[i]) SDL_FreeSurface(fs->frames[i]);
+        }
+        free(fs->frames);
+    }
+    if (fs->deltas) {
+        for (int i = 0; i < fs->count; i++) {
+            free(fs->deltas[i].tiles);
+            free(fs->deltas[i].pixels);
+        }
+        free(fs->deltas);
+    }
+    for (int i = 0; i < fs->scratchCount; i++) SDL_FreeSurface(fs->scratch[i].surf);
+    free(fs->scratch);
+    free(fs->blank);
+    if (fs->key) SDL_FreeSurface(fs->key);
+    FrameStrip empty = {0};
+    *fs = empty;
+}
+
+static void applyDelta(FrameStrip *fs, SDL_Surface *dst, int index) {
+    const StripDelta *d = &fs->deltas[index];
+    for (int k = 0; k < d->tileCount; k++) {
+        int x, y, tw, th;
+        tileRect(fs, d->tiles[k], dst->w, dst->h, &x, &y, &tw, &th);
+        const Uint32 *src = d->pixels + (size_t)k * STRIP_TILE * STRIP_TILE;
+        for (int r = 0; r < th; r++) {
+            memcpy((Uint8 *)dst->pixels + (y + r) * dst->pitch + x * 4, src + r * STRIP_TILE, tw * 4);
+        }
+    }
+}
+
+SDL_Surface *strip_frame(FrameStrip *fs, int index, Uint32 stamp) {
+    if (index < 0 || index >= fs->count) return NULL;
+    if (!fs->delta) return fs->frames[index];
+    if (fs->blank[index]) return NULL;
+    if (index == 0) return fs->key;
+
+    // Already decoded somewhere?
+    StripScratch *slot = NULL;
+    for (int i = 0; i < fs->scratchCount; i++) {
+        if (fs->scratch[i].frame == index) {
+            fs->scratch[i].stamp = stamp;
+            return fs->scratch[i].surf;
+        }
+    }
+
+    // Prefer the free slot closest behind the target, so decoding only
+    // rolls forward a few deltas instead of starting from the keyframe
+    for (int i = 0; i < fs->scratchCount; i++) {
+        StripScratch *s = &fs->scratch[i];
+        if (s->stamp == stamp) continue;
+        if (!slot || (s->frame <= index && (slot->frame > index || s->frame > slot->frame))) slot = s;
+    }
+    if (!slot) {
+        StripScratch *grown = realloc(fs->scratch, (fs->scratchCount + 1) * sizeof(StripScratch));
+        if (!grown) return NULL;
+        fs->scratch = grown;
+        slot = &fs->scratch[fs->scratchCount];
+        slot->surf = blankLike(fs->key);
+        slot->frame = -1;
+        if (!slot->surf) return NULL;
+        fs->scratchCount++;
+    }
+
+    SDL_LockSurface(slot->surf);
+    int from = slot->frame;
+    if (from < 0 || from > index) {
+        SDL_LockSurface(fs->key);
+        for (int r = 0; r < fs->key->h; r++) {
+            memcpy((Uint8 *)slot->surf->pixels + r * slot->surf->pitch,
+                   (Uint8 *)fs->key->pixels + r * fs->key->pitch, fs->key->w * 4);
+        }
+        SDL_UnlockSurface(fs->key);
+        from = 0;
+    }
+    for (int i = from + 1; i <= index; i++) applyDelta(fs, slot->surf, i);
+    SDL_UnlockSurface(slot->surf);
+
+    slot->frame = index;
+    slot->stamp = stamp;
+    return slot->surf;
+}
+
+size_t strip_bytes(const FrameStrip *fs) {
+    size_t bytes = 0;
+    if (!fs->delta) {
+        for (int i = 0; i < fs->count; i++) {
+            if (fs->frames[i]) bytes += (size_t)fs->frames[i]->pitch * fs->frames[i]->h;
+        }
+        return bytes;
+    }
+    bytes += (size_t)fs->key->pitch * fs->key->h;
+    for (int i = 0; i < fs->count; i++) {
+        bytes += fs->deltas[i].tileCount * (sizeof(Uint16) + STRIP_TILE * STRIP_TILE * sizeof(Uint32));
+    }
+    for (int i = 0; i < fs->scratchCount; i++) {
+        bytes += (size_t)fs->scratch[i].surf->pitch * fs->scratch[i].surf->h;
+    }
+    return bytes;
+}
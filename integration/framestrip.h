@@ -0,0 +1,47 @@
+#ifndef FRAMESTRIP_H
+#define FRAMESTRIP_H
+
+#include <SDL/SDL.h>
+#include <stddef.h>
+
+// One animation's frames, stored either as plain surfaces or as a keyframe
+// plus the 16x16 tiles that change from each frame to the next. Delta strips
+// decode into scratch surfaces only when a requested frame is not already
+// decoded; a scratch slot is never reused within the frame it was handed out,
+// so several entities can show different frames of one clip at once.
+
+#define STRIP_TILE 16
+
+typedef struct {
+    int tileCount;
+    Uint16 *tiles;      // tile indices, row-major
+    Uint32 *pixels;     // STRIP_TILE * STRIP_TILE per tile
+} StripDelta;
+
+typedef struct {
+    SDL_Surface *surf;
+    int frame;          // decoded frame, -1 if none
+    Uint32 stamp;       // last frame stamp it was handed out on
+} StripScratch;
+
+typedef struct {
+    int count;
+    int delta;
+    SDL_Surface **frames;       // full mode: owned frames, NULL allowed
+    // delta mode
+    SDL_Surface *key;           // frame 0
+    StripDelta *deltas;         // [count], deltas[0] unused
+    Uint8 *blank;               // [count], frame has no image
+    StripScratch *scratch;
+    int scratchCount;
+    int tilesX, tilesY;
+} FrameStrip;
+
+// Takes ownership of `frames`. With `delta` set and frames that share one
+// 32-bit size, they are encoded and freed; otherwise they are kept as they are.
+int  strip_init(FrameStrip *fs, SDL_Surface **frames, int count, int delta);
+void strip_free(FrameStrip *fs);
+SDL_Surface *strip_frame(FrameStrip *fs, int index, Uint32 stamp);
+size_t strip_bytes(const FrameStrip *fs);
+
+#endif
@@ -3,14 +3,65 @@
 #include <SDL/SDL_image.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include "jobs.h"
+#include "render_queue.h"
+#include "world.h"
+#include "minimap.h"
+#include "rotcache.h"
+#include "anim.h"
+#include "framestrip.h"
+#include "dynres.h"
+#include "memtrack.h"
+#include "input.h"
+#include "capture.h"
+#include "arena.h"
+#include "netplay.h"
 
 #define IDLE_FRAMES 4
 #define MOVE_FRAMES 4
 #define DEATH_FRAMES 4
-#define ENEMY_MAX_HEALTH 6
 #define HURT_FRAMES 1
-#define MAX_OBSTACLES 3
+#define ROTATION_STEPS 16
+#define BARRIER_ANGLE 90
+#define FRAME_BUDGET_MS 16      // work per frame before the resolution drops
+#define DELTA_FRAME_STORAGE 1   // keep enemy animations as keyframe + tile deltas
+#define NET_CONNECT_MS 30000    // how long --netplay waits for the other player
+#define NET_MAX_CATCHUP 4       // fixed steps one drawn frame may run
+
+// Enemy animation clips, named in arena.h's order
+static const char *const clipNames[CLIP_COUNT] = {"idle", "turn", "hurt", "death"};
+
+// Render queue layers
+#define LAYER_BACKGROUND 0
+#define LAYER_PROPS 1
+#define LAYER_ENEMIES 2
+#define LAYER_PLAYER 3
+
+// Minimap marker slots, in drawing order
+#define MINIMAP_SLOT_PLAYER 0
+#define MINIMAP_SLOT_ENEMY(i) (1 + (i))
+#define MINIMAP_SLOT_OBSTACLE(i) (1 + ENEMY_COUNT + (i))
+#define MINIMAP_SLOT_BARRIER (1 + ENEMY_COUNT + MAX_OBSTACLES)
+#define MINIMAP_SLOT_PLAYER2 (2 + ENEMY_COUNT + MAX_OBSTACLES)
+
+// Netplay runs the arena through these, with both players' keys
+typedef struct {
+    ArenaSim *arena;
+    const AnimSet *clips;
+} NetArena;
+
+static void netStep(void *user, const Uint8 *inputs) {
+    NetArena *n = user;
+    ArenaInput in[NET_PLAYERS];
+    for (int p = 0; p < NET_PLAYERS; p++) in[p] = arena_input_unpack(inputs[p]);
+    arena_step(n->arena, in, n->clips, ARENA_DT_MS, true);
+}
+
+static Uint32 netChecksum(void *user) {
+    return arena_checksum(((NetArena *)user)->arena);
+}
 
 SDL_Surface* resizeImage(SDL_Surface* surface, int newWidth, int newHeight) {
     SDL_Surface* resized = SDL_CreateRGBSurface(SDL_SWSURFACE, newWidth, newHeight,
@@ -47,15 +98,36 @@ SDL_Surface* flipSurface(SDL_Surface *surface) {
     return flipped;
 }
 
-bool checkCollision(SDL_Rect a, SDL_Rect b) {
-    return (a.x < b.x + b.w &&
-            a.x + a.w > b.x &&
-            a.y < b.y + b.h &&
-            a.y + a.h > b.y);
-}
-
 int main(int argc, char *argv[]) {
-    SDL_Init(SDL_INIT_VIDEO);
+    // --batch N [--seed S]: play N seeded arenas with a bot, headless and
+    // unthrottled. Assets still load as usual to get the sizes, so the video
+    // driver is the dummy one and no window opens.
+    // --netplay [--peer HOST] [--player 1|2] [--delay N] [--rollback N]: two
+    // players, one per process; on one machine the first started is player 1.
+    int batchRuns = 0;
+    Uint32 seed = (Uint32)time(NULL);
+    bool netplay = false;
+    const char *peerHost = "127.0.0.1";
+    int netPlayer = -1, netDelay = 2, netRollback = 8;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) batchRuns = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = (Uint32)strtoul(argv[++i], NULL, 0);
+        else if (strcmp(argv[i], "--netplay") == 0) netplay = true;
+        else if (strcmp(argv[i], "--peer") == 0 && i + 1 < argc) peerHost = argv[++i];
+        else if (strcmp(argv[i], "--player") == 0 && i + 1 < argc) {
+            netPlayer = atoi(argv[++i]) - 1;
+            if (netPlayer < 0 || netPlayer >= NET_PLAYERS) {
+                printf("--player takes 1 or 2\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--delay") == 0 && i + 1 < argc) netDelay = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--rollback") == 0 && i + 1 < argc) netRollback = atoi(argv[++i]);
+    }
+    if (batchRuns > 0) netplay = false;
+    if (batchRuns > 0) setenv("SDL_VIDEODRIVER", "dummy", 1);
+
+    input_sdl_init(SDL_INIT_VIDEO);
     IMG_Init(IMG_INIT_PNG | IMG_INIT_JPG);
 
     SDL_Surface *background = IMG_Load("background.jpg");
@@ -63,30 +135,42 @@ int main(int argc, char *argv[]) {
     SDL_WM_SetCaption("el kaboul ddrmech", NULL);
 
     // Load minimap image
+    memtrack_category("minimap");
     SDL_Surface *minimapImage = IMG_Load("mini.jpeg");
     if (!minimapImage) {
         printf("Failed to load minimap image!\n");
         return 1;
     }
-    SDL_Surface *minimap = resizeImage(minimapImage, 356, 156);
+    SDL_Surface *scaledMinimap = resizeImage(minimapImage, 356, 156);
     SDL_FreeSurface(minimapImage);
-    
-    // Create dot surfaces for minimap
-    SDL_Surface *redDot = SDL_CreateRGBSurface(SDL_SWSURFACE, 7, 12, 32, 0, 0, 0, 0);
-    SDL_FillRect(redDot, NULL, SDL_MapRGB(redDot->format, 255, 0, 0));
-    
-    SDL_Surface *blueDot = SDL_CreateRGBSurface(SDL_SWSURFACE, 7, 12, 32, 0, 0, 0, 0);
-    SDL_FillRect(blueDot, NULL, SDL_MapRGB(blueDot->format, 0, 0, 255));
+
+    // Minimap in the top-left corner, kept in screen format with its markers
+    Minimap minimap;
+    if (minimap_init(&minimap, scaledMinimap, 10, 10, background->w, background->h) != 0) {
+        printf("Failed to create minimap!\n");
+        return 1;
+    }
+    SDL_FreeSurface(scaledMinimap);
+
+    // Marker colours, mapped once
+    Uint32 redColor = SDL_MapRGB(minimap.view->format, 255, 0, 0);
+    Uint32 blueColor = SDL_MapRGB(minimap.view->format, 0, 0, 255);
+    Uint32 blackColor = SDL_MapRGB(minimap.view->format, 0, 0, 0);
+    Uint32 greyColor = SDL_MapRGB(minimap.view->format, 128, 128, 128);
+    Uint32 greenColor = SDL_MapRGB(minimap.view->format, 0, 160, 0);
 
     // Load obstacle images
+    memtrack_category("props");
     SDL_Surface *obstacles[MAX_OBSTACLES];
-    SDL_Rect obstaclePos[MAX_OBSTACLES] = {
-        {200, 780, 50, 30},
-        {100, 780, 50, 30}, 
-        {600, 780, 50, 30}
+    ArenaLayout layout = {
+        background->w, background->h,
+        .obstacles = {
+            {200, 780, 50, 30},
+            {100, 780, 50, 30},
+            {600, 780, 50, 30}
+        }
     };
-    bool obstacleActive[MAX_OBSTACLES] = {true, true, true};
-    
+
     for (int i = 0; i < MAX_OBSTACLES; i++) {
         char filename[32];
         snprintf(filename, sizeof(filename), "g%d.jpeg", i);
@@ -95,6 +179,9 @@ int main(int argc, char *argv[]) {
             printf("Failed to load obstacle image %s\n", filename);
             return 1;
         }
+        // Collision box is the drawn size
+        layout.obstacles[i].w = obstacles[i]->w;
+        layout.obstacles[i].h = obstacles[i]->h;
     }
 
     // Load vertical barrier image
@@ -103,12 +190,19 @@ int main(int argc, char *argv[]) {
         printf("Failed to load barrier image!\n");
         return 1;
     }
-    // Make the barrier vertical by rotating its dimensions
-    SDL_Rect barrierPos = {600, 0, barrier->h, barrier->w}; // Note: w and h are swapped
+    // Pre-rotate the barrier once; drawing it is then a plain blit
+    RotCache barrierRot;
+    if (rotcache_init(&barrierRot, barrier, ROTATION_STEPS) != 0) {
+        printf("Failed to rotate barrier image!\n");
+        return 1;
+    }
+    SDL_FreeSurface(barrier);
+    const RotFrame *barrierFrame = rotcache_frame(&barrierRot, BARRIER_ANGLE);
+    // Collision box is the opaque part of the rotated frame
+    layout.barrier = (WorldRect){600, 0, barrierFrame->boxW, barrierFrame->boxH};
     bool barrierActive = true;
-    int barrierDirection = 1; // 1 = descending, -1 = ascending
-    int barrierSpeed = 3;
 
+    memtrack_category("enemy");
     SDL_Surface *idleRight[IDLE_FRAMES], *idleLeft[IDLE_FRAMES];
     SDL_Surface *moveRight[MOVE_FRAMES], *moveLeft[MOVE_FRAMES];
     SDL_Surface *death[DEATH_FRAMES];
@@ -164,265 +258,276 @@ int main(int argc, char *argv[]) {
         SDL_FreeSurface(temp);
     }
 
+    const int enemyW = idleLeft[0]->w, enemyH = idleLeft[0]->h;
+    layout.enemyW = enemyW;
+    layout.enemyH = enemyH;
+
+    // Frame strips for each clip, [clip][facing right]. The death clip ends
+    // on a blank frame, so the body disappears once it has played.
+    AnimSet enemyClips;
+    if (anim_load(&enemyClips, "enemy.clips", clipNames, CLIP_COUNT, NULL, 0) != 0) {
+        return 1;
+    }
+    SDL_Surface *deathFrames[DEATH_FRAMES + 1];
+    for (int i = 0; i < DEATH_FRAMES; ++i) deathFrames[i] = death[i];
+    deathFrames[DEATH_FRAMES] = NULL;
+    FrameStrip idleStrip[2], moveStrip[2], hurtStrip[2], attackStrip[2], deathStrip;
+    if (strip_init(&idleStrip[0], idleLeft, IDLE_FRAMES, DELTA_FRAME_STORAGE) != 0 ||
+        strip_init(&idleStrip[1], idleRight, IDLE_FRAMES, DELTA_FRAME_STORAGE) != 0 ||
+        strip_init(&moveStrip[0], moveLeft, MOVE_FRAMES, DELTA_FRAME_STORAGE) != 0 ||
+        strip_init(&moveStrip[1], moveRight, MOVE_FRAMES, DELTA_FRAME_STORAGE) != 0 ||
+        strip_init(&hurtStrip[0], hurtLeft, HURT_FRAMES, DELTA_FRAME_STORAGE) != 0 ||
+        strip_init(&hurtStrip[1], hurtRight, HURT_FRAMES, DELTA_FRAME_STORAGE) != 0 ||
+        strip_init(&attackStrip[0], attackLeft, MOVE_FRAMES, DELTA_FRAME_STORAGE) != 0 ||
+        strip_init(&attackStrip[1], attackRight, MOVE_FRAMES, DELTA_FRAME_STORAGE) != 0 ||
+        strip_init(&deathStrip, deathFrames, DEATH_FRAMES + 1, DELTA_FRAME_STORAGE) != 0) {
+        printf("Failed to build enemy frame strips!\n");
+        return 1;
+    }
+    FrameStrip *clipSprites[CLIP_COUNT][2] = {
+        [CLIP_IDLE] = {&idleStrip[0], &idleStrip[1]},
+        [CLIP_TURN] = {&moveStrip[0], &moveStrip[1]},
+        [CLIP_HURT] = {&hurtStrip[0], &hurtStrip[1]},
+        [CLIP_DEATH] = {&deathStrip, &deathStrip},
+    };
+    const int clipFrames[CLIP_COUNT] = {IDLE_FRAMES, MOVE_FRAMES, HURT_FRAMES, DEATH_FRAMES + 1};
+    for (int c = 0; c < CLIP_COUNT; c++) {
+        if (anim_max_frame(&enemyClips, c) >= clipFrames[c]) {
+            printf("Clip '%s' uses more frames than were loaded!\n", clipNames[c]);
+            return 1;
+        }
+    }
+
+    memtrack_category("player");
     SDL_Surface *player = IMG_Load("me/me.png");
     SDL_Surface *resizedPlayer = resizeImage(player, player->w / 4, player->h / 4);
     SDL_FreeSurface(player);
     
     // Fixed Y position for player (same as enemies)
     const int PLAYER_BASE_Y = 820;
-    SDL_Rect posPlayer = {
+    layout.player = (WorldRect){
         screen->w / 2 - resizedPlayer->w / 2,
-        PLAYER_BASE_Y - resizedPlayer->h
+        PLAYER_BASE_Y - resizedPlayer->h,
+        resizedPlayer->w,
+        resizedPlayer->h
     };
 
-    // Original enemy positions (100,210) and (300,210)
-    SDL_Rect posEnemy[2] = {
-        {100, 820 - idleRight[0]->h},  // Adjusted for sprite height
-        {300, 820 - idleRight[0]->h}
-    };
-    
-    int moveDirection[2] = {1, -1};
-    int directionAnimationFrame[2] = {0};
-    bool isChangingDirection[2] = {false};
-    int enemyHealth[2] = {ENEMY_MAX_HEALTH, ENEMY_MAX_HEALTH};
-    bool isDying[2] = {false};
-    int deathFrame[2] = {0};
-    bool isHurt[2] = {false};
-    Uint32 hurtEndTime[2] = {0};
-    int moveDistance = 2;
-    int currentFrame = 0, frameDelay = 0;
+    // With a peer, both sides start from player 1's seed
+    NetPlay net;
+    bool netOk = netplay && netplay_open(&net, peerHost, netPlayer, netDelay, netRollback, seed) == 0;
+    if (netOk && netplay_connect(&net, NET_CONNECT_MS) != 0) {
+        netplay_close(&net);
+        netOk = false;
+    }
+    if (netOk) seed = net.seed;
+    else if (netplay) printf("Playing alone\n");
+
+    // The rules live in arena.c; this loop feeds them keys and draws the result
+    ArenaSim arena;
+    arena_init(&arena, &layout, netOk ? NET_PLAYERS : 1, seed);
+    NetArena netArena = {&arena, &enemyClips};
+    NetGame netGame = {&arena, sizeof(arena), &netArena, netStep, netChecksum};
+    if (netOk && netplay_start(&net, &netGame) != 0) {
+        netplay_close(&net);
+        netOk = false;
+        arena.players = 1;
+    }
+    Uint32 netClock = 0;    // real time not yet turned into fixed steps
+    const Enemies *enemies = &arena.enemies;
+    Uint32 lastTicks = SDL_GetTicks();
+    if (netOk) lastTicks = net.startTicks;
+    Uint32 frameStamp = 0;   // lets frame strips tell one frame's draws from the next
 
     SDL_Event event;
     bool running = true;
-    bool isAttacking = false;
-    srand(time(NULL));
-
-    // Minimap position and scaling factors
-    SDL_Rect minimapPos = {10, 10}; // Top-left corner
-    float scaleX = (float)minimap->w / background->w;
-    float scaleY = (float)minimap->h / background->h;
+    // Keys as of the tick being simulated, rebuilt from the timestamped queue
+    ArenaInput keys = {0};
+    input_start();
+
+    // F12 saves a screenshot, F11 starts and stops recording; --record
+    // records from the first frame, which also works with no keyboard
+    Capture capture;
+    bool captureOk = batchRuns == 0 && capture_open(&capture, screen->w, screen->h) == 0;
+    for (int i = 1; i < argc && captureOk; i++) {
+        if (strcmp(argv[i], "--record") == 0) capture_video(&capture, 1);
+    }
+    jobs_init(0);
+    if (batchRuns > 0) {
+        arena_batch(&layout, &enemyClips, batchRuns, seed, stdout);
+        running = false;
+    }
+    RenderQueue rq;
+    rq_init(&rq);
 
-    // Black color for obstacles on minimap
-    Uint32 blackColor = SDL_MapRGB(screen->format, 0, 0, 0);
+    DynRes dynres;
+    dynres_init(&dynres, FRAME_BUDGET_MS);
+    // From here on, surfaces are per-frame buffers that should stop growing
+    // once warmed up; a resolution change makes new ones and starts over
+    memtrack_category("frame");
+    int trackedScale = dynres_scale(&dynres);
 
     while (running) {
+        Uint32 frameStart = SDL_GetTicks();
         while (SDL_PollEvent(&event)) {
-            if (event.type == SDL_QUIT || (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_ESCAPE))
+            if (event.type == SDL_QUIT)
                 running = false;
         }
 
-        Uint8 *keystates = SDL_GetKeyState(NULL);
-
-        // Only horizontal movement for player
-        if (keystates[SDLK_LEFT]) posPlayer.x -= 4;
-        if (keystates[SDLK_RIGHT]) posPlayer.x += 4;
-
-        // Move the barrier up and down
-        barrierPos.y += barrierSpeed * barrierDirection;
-        
-        // Reverse direction when barrier reaches top or bottom
-        if (barrierPos.y <= 0) {
-            barrierPos.y = 0;
-            barrierDirection = 1; // Start descending
-        } else if (barrierPos.y + barrierPos.h >= background->h) {
-            barrierPos.y = background->h - barrierPos.h;
-            barrierDirection = -1; // Start ascending
-        }
-
-        // Check collision with barrier (prevent passing through)
-        if (checkCollision(posPlayer, barrierPos)) {
-            // Push player left or right based on which side they're approaching from
-            if (posPlayer.x + posPlayer.w/2 < barrierPos.x + barrierPos.w/2) {
-                posPlayer.x = barrierPos.x - posPlayer.w;
-            } else {
-                posPlayer.x = barrierPos.x + barrierPos.w;
+        // Apply every key event up to now, in order; a tap shorter than a
+        // frame still counts as an attack
+        Uint32 tick = input_now();
+        InputEvent input;
+        while (input_poll(&input, tick)) {
+            bool down = input.event.type == SDL_KEYDOWN;
+            SDLKey key = input.event.key.keysym.sym;
+            if (key == SDLK_ESCAPE && down) running = false;
+            if (key == SDLK_F12 && down && captureOk) capture_still(&capture);
+            if (key == SDLK_F11 && down && captureOk) capture_video(&capture, !capture.recording);
+            if (key == SDLK_LEFT) keys.left = down;
+            if (key == SDLK_RIGHT) keys.right = down;
+            if (key == SDLK_e) {
+                keys.attack = down;
+                if (down) keys.attackTapped = true;
             }
+            if (key == SDLK_LEFT || key == SDLK_RIGHT || key == SDLK_e) input_probe_mark(input.time);
         }
 
-        // Check if the 'E' key is pressed for attacking
-        if (keystates[SDLK_e] && !isAttacking) {
-            isAttacking = true;
-
-            for (int i = 0; i < 2; i++) {
-                SDL_Rect enemyRect = {
-                    posEnemy[i].x, 
-                    posEnemy[i].y, 
-                    idleRight[0]->w, 
-                    idleRight[0]->h
-                };
-                SDL_Rect playerRect = {
-                    posPlayer.x, 
-                    posPlayer.y, 
-                    resizedPlayer->w, 
-                    resizedPlayer->h
-                };
-
-                if (checkCollision(enemyRect, playerRect)) {
-                    if (enemyHealth[i] > 0 && !isDying[i]) {
-                        enemyHealth[i]--;
-                        if (enemyHealth[i] < 0) enemyHealth[i] = 0;
-                        isHurt[i] = true;
-                        hurtEndTime[i] = SDL_GetTicks() + 200;
-                    }
-                }
+        Uint32 nowTicks = SDL_GetTicks();
+        if (netOk) {
+            // Fixed steps in lockstep with the peer; the keys are held until
+            // netplay takes them, so a tap is not lost while it waits
+            netClock += nowTicks - lastTicks;
+            if (netClock > NET_MAX_CATCHUP * ARENA_DT_MS) netClock = NET_MAX_CATCHUP * ARENA_DT_MS;
+            for (; netClock >= ARENA_DT_MS; netClock -= ARENA_DT_MS) {
+                netplay_poll(&net);
+                if (netplay_push(&net, arena_input_pack(&keys))) keys.attackTapped = false;
+                netplay_advance(&net);
             }
+            if (net.peerGone) running = false;
+        } else {
+            // Every enemy animation advances by the real elapsed time
+            arena_step(&arena, &keys, &enemyClips, nowTicks - lastTicks, true);
+            keys.attackTapped = false;
         }
+        lastTicks = nowTicks;
 
-        if (!keystates[SDLK_e]) {
-            isAttacking = false;
-        }
-
-        frameDelay++;
-        if (frameDelay >= 5) {
-            currentFrame = (currentFrame + 1) % IDLE_FRAMES;
-            frameDelay = 0;
-        }
-
-        SDL_BlitSurface(background, NULL, screen, NULL);
+        // Whole arena fits on screen, so the camera sits at the origin
+        frameStamp++;
+        rq_set_scale(&rq, dynres_scale(&dynres));
+        rq_begin(&rq, 0, 0, screen->w, screen->h);
+        rq_blit(&rq, LAYER_BACKGROUND, background, NULL, 0, 0);
 
         // Draw obstacles
         for (int i = 0; i < MAX_OBSTACLES; i++) {
-            if (obstacleActive[i]) {
-                SDL_BlitSurface(obstacles[i], NULL, screen, &obstaclePos[i]);
-                
-                // Check collision with player
-                if (checkCollision(posPlayer, obstaclePos[i])) {
-                    obstacleActive[i] = false;
-                }
+            if (arena.obstacleActive[i]) {
+                rq_blit(&rq, LAYER_PROPS, obstacles[i], NULL, arena.obstaclePos[i].x, arena.obstaclePos[i].y);
             }
         }
 
         // Draw vertical barrier
-        SDL_BlitSurface(barrier, NULL, screen, &barrierPos);
-
-        for (int i = 0; i < 2; i++) {
-            if (!isChangingDirection[i] && !isDying[i] && (rand() % 100 < 1)) {
-                isChangingDirection[i] = true;
-                directionAnimationFrame[i] = 0;
-                moveDirection[i] *= -1;
-            }
-
-            if (!isChangingDirection[i] && !isDying[i]) {
-                posEnemy[i].x += moveDirection[i] * moveDistance;
-                
-                // Check collision with barrier for enemies
-                if (checkCollision(posEnemy[i], barrierPos)) {
-                    moveDirection[i] *= -1;
-                    posEnemy[i].x += moveDirection[i] * moveDistance * 2; // Push back
-                }
-                
-                if (posEnemy[i].x < 0 || posEnemy[i].x > background->w - idleRight[0]->w)
-                    moveDirection[i] *= -1;
-            }
-
-            SDL_Rect enemyRect = {
-                posEnemy[i].x, 
-                posEnemy[i].y, 
-                idleRight[0]->w, 
-                idleRight[0]->h
-            };
-            SDL_Rect playerRect = {
-                posPlayer.x, 
-                posPlayer.y, 
-                resizedPlayer->w, 
-                resizedPlayer->h
-            };
-
-            if (checkCollision(enemyRect, playerRect)) {
-                // Do nothing here since health only reduces on 'E' key press
-            }
-
-            if (isDying[i]) {
-                if (deathFrame[i] < DEATH_FRAMES * 6) {
-                    SDL_BlitSurface(death[deathFrame[i] / 6], NULL, screen, &posEnemy[i]);
-                    deathFrame[i]++;
-                }
-            } else if (isHurt[i]) {
-                SDL_BlitSurface((moveDirection[i] == 1 ? hurtRight[0] : hurtLeft[0]), NULL, screen, &posEnemy[i]);
-                if (SDL_GetTicks() > hurtEndTime[i]) isHurt[i] = false;
-            } else if (isChangingDirection[i]) {
-                SDL_BlitSurface((moveDirection[i] == 1 ? moveRight : moveLeft)[directionAnimationFrame[i]], NULL, screen, &posEnemy[i]);
-                directionAnimationFrame[i]++;
-                if (directionAnimationFrame[i] >= MOVE_FRAMES) isChangingDirection[i] = false;
-            } else {
-                SDL_BlitSurface((moveDirection[i] == 1 ? idleRight : idleLeft)[currentFrame], NULL, screen, &posEnemy[i]);
-            }
-
-            if (enemyHealth[i] <= 0 && !isDying[i]) {
-                isDying[i] = true;
-            }
+        rq_blit(&rq, LAYER_PROPS, barrierFrame->surf, NULL,
+                arena.barrier.x - barrierFrame->boxX, arena.barrier.y - barrierFrame->boxY);
+
+        for (int i = 0; i < ENEMY_COUNT; i++) {
+            const AnimState *a = &enemies->anim[i];
+            FrameStrip *strip = clipSprites[a->clip][enemies->moveDirection[i] == 1];
+            int frame = anim_frame(&enemyClips, a);
+            SDL_Surface *sprite = strip_frame(strip, frame, frameStamp);
+            // Strip scratch surfaces are reused for other frames, so the frame tags the picture
+            if (sprite) rq_blit_tagged(&rq, LAYER_ENEMIES, sprite, NULL, enemies->pos[i].x, enemies->pos[i].y, frame + 1);
+        }
 
-            if (!isDying[i]) {
-                if (enemyHealth[i] > 0) {
-                    SDL_Rect healthPos = {screen->w - healthBar[0]->w - 50, 20 + i * 40};
-                    SDL_BlitSurface(healthBar[ENEMY_MAX_HEALTH - enemyHealth[i]], NULL, screen, &healthPos);
-                }
+        for (int p = 0; p < arena.players; p++) {
+            rq_blit(&rq, LAYER_PLAYER, resizedPlayer, NULL, arena.player[p].x, arena.player[p].y);
+        }
+        rq_flush(&rq, dynres_target(&dynres, screen));
+        dynres_present(&dynres, screen);
+
+        // Health bars
+        for (int i = 0; i < ENEMY_COUNT; i++) {
+            if (!enemies->isDying[i] && enemies->health[i] > 0) {
+                SDL_Rect healthPos = {screen->w - healthBar[0]->w - 50, 20 + i * 40};
+                SDL_BlitSurface(healthBar[ENEMY_MAX_HEALTH - enemies->health[i]], NULL, screen, &healthPos);
             }
         }
-
-        SDL_BlitSurface(resizedPlayer, NULL, screen, &posPlayer);
         
-        // Draw minimap on the left side
-        SDL_BlitSurface(minimap, NULL, screen, &minimapPos);
-        
-        // Draw player position as blue dot on minimap (centered)
-        SDL_Rect playerDotPos = {
-            minimapPos.x + (int)((posPlayer.x + resizedPlayer->w/2) * scaleX) - blueDot->w/2,
-            minimapPos.y + (int)((posPlayer.y + resizedPlayer->h/2) * scaleY) - blueDot->h/2
-        };
-        SDL_BlitSurface(blueDot, NULL, screen, &playerDotPos);
-        
-        // Draw enemy positions as red dots on minimap (centered)
-        for (int i = 0; i < 2; i++) {
-            if (!isDying[i]) {
-                SDL_Rect enemyDotPos = {
-                    minimapPos.x + (int)((posEnemy[i].x + idleRight[0]->w/2) * scaleX) - redDot->w/2,
-                    minimapPos.y + (int)((posEnemy[i].y + idleRight[0]->h/2) * scaleY) - redDot->h/2
-                };
-                SDL_BlitSurface(redDot, NULL, screen, &enemyDotPos);
+        // Minimap: player as a blue dot (the second one green), enemies red, obstacles black (centered)
+        minimap_place(&minimap, MINIMAP_SLOT_PLAYER,
+                      arena.player[0].x + resizedPlayer->w/2, arena.player[0].y + resizedPlayer->h/2, -3, -6, 7, 12, blueColor);
+        for (int i = 0; i < ENEMY_COUNT; i++) {
+            if (!enemies->isDying[i]) {
+                minimap_place(&minimap, MINIMAP_SLOT_ENEMY(i),
+                              enemies->pos[i].x + enemyW/2, enemies->pos[i].y + enemyH/2, -3, -6, 7, 12, redColor);
+            } else {
+                minimap_hide(&minimap, MINIMAP_SLOT_ENEMY(i));
             }
         }
-        
-        // Draw obstacles on minimap (black dots)
         for (int i = 0; i < MAX_OBSTACLES; i++) {
-            if (obstacleActive[i]) {
-                SDL_Rect obstacleDotPos = {
-                    minimapPos.x + (int)((obstaclePos[i].x + obstaclePos[i].w/2) * scaleX) - 2,
-                    minimapPos.y + (int)((obstaclePos[i].y + obstaclePos[i].h/2) * scaleY) - 2,
-                    8, 8
-                };
-                SDL_FillRect(screen, &obstacleDotPos, blackColor);
+            if (arena.obstacleActive[i]) {
+                minimap_place(&minimap, MINIMAP_SLOT_OBSTACLE(i),
+                              arena.obstaclePos[i].x + arena.obstaclePos[i].w/2, arena.obstaclePos[i].y + arena.obstaclePos[i].h/2, -2, -2, 8, 8, blackColor);
+            } else {
+                minimap_hide(&minimap, MINIMAP_SLOT_OBSTACLE(i));
             }
         }
-        
-        // Draw barrier on minimap (gray rectangle)
-        SDL_Rect barrierDotPos = {
-            minimapPos.x + (int)((barrierPos.x + barrierPos.w/2) * scaleX) - 2,
-            minimapPos.y + (int)((barrierPos.y + barrierPos.h/2) * scaleY) - 2,
-            4, (int)(barrierPos.h * scaleY)
-        };
-        SDL_FillRect(screen, &barrierDotPos, SDL_MapRGB(screen->format, 128, 128, 128));
+        // Barrier as a gray bar
+        minimap_place(&minimap, MINIMAP_SLOT_BARRIER, arena.barrier.x + arena.barrier.w/2, arena.barrier.y + arena.barrier.h/2,
+                      -2, -2, 4, minimap_scale_y(&minimap, arena.barrier.h), greyColor);
+        if (arena.players > 1) {
+            minimap_place(&minimap, MINIMAP_SLOT_PLAYER2,
+                          arena.player[1].x + resizedPlayer->w/2, arena.player[1].y + resizedPlayer->h/2, -3, -6, 7, 12, greenColor);
+        }
+        minimap_draw(&minimap, screen);
 
         SDL_Flip(screen);
+        input_probe_flip();
+        if (captureOk) capture_frame(&capture, screen);
+        dynres_frame(&dynres, SDL_GetTicks() - frameStart);
+        memtrack_frame();
+        if (dynres_scale(&dynres) != trackedScale) {
+            trackedScale = dynres_scale(&dynres);
+            memtrack_settle();
+        }
         SDL_Delay(16);
     }
 
     // Cleanup code
+    input_stop();
+    input_report(stdout);
+    if (captureOk) {
+        capture_close(&capture);
+        capture_report(&capture, stdout);
+    }
+    if (netOk) {
+        netplay_report(&net, stdout);
+        netplay_close(&net);
+    }
+    jobs_shutdown();
+    rq_report(&rq, stdout);
+    rq_free(&rq);
+    dynres_report(&dynres, stdout);
+    dynres_free(&dynres);
     for (int i = 0; i < MAX_OBSTACLES; i++) {
         SDL_FreeSurface(obstacles[i]);
     }
     SDL_FreeSurface(background);
-    SDL_FreeSurface(minimap);
-    SDL_FreeSurface(redDot);
-    SDL_FreeSurface(blueDot);
-    SDL_FreeSurface(barrier);
-    for (int i = 0; i < IDLE_FRAMES; ++i) SDL_FreeSurface(idleLeft[i]);
-    for (int i = 0; i < MOVE_FRAMES; ++i) SDL_FreeSurface(moveLeft[i]);
-    for (int i = 0; i < DEATH_FRAMES; ++i) SDL_FreeSurface(death[i]);
+    minimap_free(&minimap);
+    rotcache_free(&barrierRot);
+    FrameStrip *strips[] = {
+        &idleStrip[0], &idleStrip[1], &moveStrip[0], &moveStrip[1], &hurtStrip[0], &hurtStrip[1],
+        &attackStrip[0], &attackStrip[1], &deathStrip
+    };
+    size_t stripBytes = 0;
+    for (int i = 0; i < (int)(sizeof(strips) / sizeof(strips[0])); ++i) {
+        stripBytes += strip_bytes(strips[i]);
+        strip_free(strips[i]);
+    }
+    printf("Enemy sprite frames: %lu bytes resident\n", (unsigned long)stripBytes);
     for (int i = 0; i < ENEMY_MAX_HEALTH; ++i) SDL_FreeSurface(healthBar[i]);
     SDL_FreeSurface(resizedPlayer);
+    int memFailed = memtrack_finish(stdout);
 
     SDL_Quit();
     IMG_Quit();
-    return 0;
+    return memFailed ? 1 : 0;
 }
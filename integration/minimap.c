@@ -0,0 +1,86 @@
+#include "minimap.h"
+#include "memtrack.h"
+
+int minimap_init(Minimap *mm, SDL_Surface *image, int x, int y, int worldW, int worldH) {
+    Minimap empty = {0};
+    *mm = empty;
+    mm->base = SDL_DisplayFormat(image);
+    mm->view = SDL_DisplayFormat(image);
+    if (!mm->base || !mm->view) {
+        minimap_free(mm);
+        return -1;
+    }
+    mm->pos.x = x;
+    mm->pos.y = y;
+    mm->scaleX = (Sint32)(((Sint64)image->w << 16) / worldW);
+    mm->scaleY = (Sint32)(((Sint64)image->h << 16) / worldH);
+    return 0;
+}
+
+void minimap_free(Minimap *mm) {
+    if (mm->base) SDL_FreeSurface(mm->base);
+    if (mm->view) SDL_FreeSurface(mm->view);
+    mm->base = mm->view = NULL;
+}
+
+int minimap_scale_y(const Minimap *mm, int worldH) {
+    return (int)(((Sint64)worldH * mm->scaleY) >> 16);
+}
+
+void minimap_place(Minimap *mm, int slot, Sint32 worldX, Sint32 worldY, int dx, int dy, int w, int h, Uint32 color) {
+    MinimapMarker *m = &mm->markers[slot];
+    m->cell.x = (Sint16)(((Sint64)worldX * mm->scaleX >> 16) + dx);
+    m->cell.y = (Sint16)(((Sint64)worldY * mm->scaleY >> 16) + dy);
+    m->cell.w = w;
+    m->cell.h = h;
+    m->color = color;
+    m->visible = true;
+}
+
+void minimap_hide(Minimap *mm, int slot) {
+    mm->markers[slot].visible = false;
+}
+
+static bool sameRect(SDL_Rect a, SDL_Rect b) {
+    return a.x == b.x && a.y == b.y && a.w == b.w && a.h == b.h;
+}
+
+static bool overlaps(SDL_Rect a, SDL_Rect b) {
+    return a.x < b.x + b.w && a.x + a.w > b.x && a.y < b.y + b.h && a.y + a.h > b.y;
+}
+
+void minimap_draw(Minimap *mm, SDL_Surface *screen) {
+    int touchedCount = 0;
+
+    // Restore the map under every marker that moved, changed or vanished
+    for (int i = 0; i < MINIMAP_MAX_MARKERS; i++) {
+        MinimapMarker *m = &mm->markers[i];
+        if (!m->drawn) continue;
+        if (m->visible && sameRect(m->cell, m->drawnCell) && m->color == m->drawnColor) continue;
+        SDL_Rect cell = m->drawnCell;
+        SDL_BlitSurface(mm->base, &cell, mm->view, &cell);
+        mm->touched[touchedCount++] = m->drawnCell;
+        m->drawn = false;
+    }
+
+    // Repaint markers that are new or overlap a touched cell; later slots
+    // stay on top because each repaint is itself a touched cell
+    for (int i = 0; i < MINIMAP_MAX_MARKERS; i++) {
+        MinimapMarker *m = &mm->markers[i];
+        if (!m->visible) continue;
+        bool repaint = !m->drawn;
+        for (int t = 0; t < touchedCount && !repaint; t++) {
+            repaint = overlaps(m->cell, mm->touched[t]);
+        }
+        if (!repaint) continue;
+        SDL_Rect cell = m->cell;
+        SDL_FillRect(mm->view, &cell, m->color);
+        m->drawnCell = m->cell;
+        m->drawnColor = m->color;
+        m->drawn = true;
+        mm->touched[touchedCount++] = m->cell;
+    }
+
+    SDL_Rect dst = mm->pos;
+    SDL_BlitSurface(mm->view, NULL, screen, &dst);
+}
@@ -0,0 +1,38 @@
+#ifndef MINIMAP_H
+#define MINIMAP_H
+
+#include <SDL/SDL.h>
+#include <stdbool.h>
+
+#define MINIMAP_MAX_MARKERS 64
+
+typedef struct {
+    SDL_Rect cell;      // minimap-space, valid when visible
+    Uint32 color;
+    bool visible;
+    bool drawn;         // currently painted into the view at drawnCell
+    SDL_Rect drawnCell;
+    Uint32 drawnColor;
+} MinimapMarker;
+
+// Cached minimap: `base` is the static map in screen format, `view` is base
+// plus markers. Each frame only the cells of markers that moved are restored
+// from base and repainted, so the cost follows the markers, not the map size.
+typedef struct {
+    SDL_Surface *base;
+    SDL_Surface *view;
+    SDL_Rect pos;               // top-left corner on screen
+    Sint32 scaleX, scaleY;      // world -> minimap, 16.16 fixed point
+    MinimapMarker markers[MINIMAP_MAX_MARKERS];
+    SDL_Rect touched[MINIMAP_MAX_MARKERS * 2];   // cells restored or repainted this frame
+} Minimap;
+
+int  minimap_init(Minimap *mm, SDL_Surface *image, int x, int y, int worldW, int worldH);
+void minimap_free(Minimap *mm);
+int  minimap_scale_y(const Minimap *mm, int worldH);
+// Marker `slot` sits at (dx, dy) from the scaled world point (worldX, worldY)
+void minimap_place(Minimap *mm, int slot, Sint32 worldX, Sint32 worldY, int dx, int dy, int w, int h, Uint32 color);
+void minimap_hide(Minimap *mm, int slot);
+void minimap_draw(Minimap *mm, SDL_Surface *screen);
+
+#endif
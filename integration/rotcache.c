@@ -0,0 +1,137 @@
+#include "rotcache.h"
+#include "memtrack.h"
+#include <math.h>
+#include <stdlib.h>
+
+// Fixed-point inverse mapping: for each destination pixel centre find the
+// source pixel it came from. Stepping along a row only adds the two
+// increments, so the inner loop has no multiplies and no trig.
+static void rotateInto(SDL_Surface *src, RotFrame *f, Sint32 cosv, Sint32 sinv) {
+    SDL_Surface *dst = f->surf;
+    int sw = src->w, sh = src->h;
+    int dw = dst->w, dh = dst->h;
+    Uint32 *spix = (Uint32 *)src->pixels;
+    int spitch = src->pitch / 4;
+    Uint32 amask = src->format->Amask;
+
+    // Offsets of the pixel centres from the image centres, in 16.16
+    Sint32 ox = (Sint32)(((Sint64)sw << 15));
+    Sint32 oy = (Sint32)(((Sint64)sh << 15));
+    Sint32 hx = (1 << 15) - (dw << 15);
+
+    f->boxX = dw;
+    f->boxY = dh;
+    int maxX = -1, maxY = -1;
+
+    for (int y = 0; y < dh; y++) {
+        Sint32 ry = (y << 16) + (1 << 15) - (dh << 15);
+        Sint32 sx = (Sint32)(((Sint64)hx * cosv + (Sint64)ry * sinv) >> 16) + ox;
+        Sint32 sy = (Sint32)(((Sint64)ry * cosv - (Sint64)hx * sinv) >> 16) + oy;
+        Uint32 *drow = (Uint32 *)((Uint8 *)dst->pixels + y * dst->pitch);
+        Uint8 *mrow = f->mask + y * dw;
+
+        for (int x = 0; x < dw; x++, sx += cosv, sy -= sinv) {
+            Uint32 px = (Uint32)(sx >> 16), py = (Uint32)(sy >> 16);
+            Uint32 c = 0;
+            if (sx >= 0 && sy >= 0 && px < (Uint32)sw && py < (Uint32)sh) {
+                c = spix[py * spitch + px];
+            }
+            drow[x] = c;
+            mrow[x] = (c & amask) >= (amask & 0x80808080u);
+            if (mrow[x]) {
+                if (x < f->boxX) f->boxX = x;
+                if (y < f->boxY) f->boxY = y;
+                if (x > maxX) maxX = x;
+                if (y > maxY) maxY = y;
+            }
+        }
+    }
+
+    if (maxX < 0) {
+        f->boxX = f->boxY = f->boxW = f->boxH = 0;
+    } else {
+        f->boxW = maxX - f->boxX + 1;
+        f->boxH = maxY - f->boxY + 1;
+    }
+}
+
+int rotcache_init(RotCache *rc, SDL_Surface *src, int steps) {
+    rc->steps = 0;
+    rc->frames = NULL;
+    if (steps < 4) steps = 4;
+    steps = (steps + 3) & ~3;
+
+    SDL_Surface *argb = SDL_DisplayFormatAlpha(src);
+    if (!argb) return -1;
+
+    rc->frames = calloc(steps, sizeof(RotFrame));
+    if (!rc->frames) {
+        SDL_FreeSurface(argb);
+        return -1;
+    }
+    rc->steps = steps;
+
+    SDL_LockSurface(argb);
+    for (int i = 0; i < steps; i++) {
+        RotFrame *f = &rc->frames[i];
+        Sint32 cosv, sinv;
+        int w, h;
+
+        if (i % (steps / 4) == 0) {
+            // Quarter turns use exact unit vectors and swapped sizes
+            static const Sint32 qc[4] = {1, 0, -1, 0};
+            static const Sint32 qs[4] = {0, 1, 0, -1};
+            int q = i / (steps / 4);
+            cosv = qc[q] * 65536;
+            sinv = qs[q] * 65536;
+            w = (q & 1) ? argb->h : argb->w;
+            h = (q & 1) ? argb->w : argb->h;
+        } else {
+            double a = i * 2.0 * M_PI / steps;
+            double c = cos(a), s = sin(a);
+            cosv = (Sint32)lround(c * 65536.0);
+            sinv = (Sint32)lround(s * 65536.0);
+            w = (int)ceil(argb->w * fabs(c) + argb->h * fabs(s));
+            h = (int)ceil(argb->w * fabs(s) + argb->h * fabs(c));
+        }
+
+        SDL_PixelFormat *fmt = argb->format;
+        f->surf = SDL_CreateRGBSurface(SDL_SWSURFACE | SDL_SRCALPHA, w, h, 32,
+                                       fmt->Rmask, fmt->Gmask, fmt->Bmask, fmt->Amask);
+        f->mask = malloc((size_t)w * h);
+        if (!f->surf || !f->mask) {
+            SDL_UnlockSurface(argb);
+            SDL_FreeSurface(argb);
+            rotcache_free(rc);
+            return -1;
+        }
+        SDL_LockSurface(f->surf);
+        rotateInto(argb, f, cosv, sinv);
+        SDL_UnlockSurface(f->surf);
+    }
+    SDL_UnlockSurface(argb);
+    SDL_FreeSurface(argb);
+    return 0;
+}
+
+void rotcache_free(RotCache *rc) {
+    for (int i = 0; i < rc->steps; i++) {
+        if (rc->frames[i].surf) SDL_FreeSurface(rc->frames[i].surf);
+        free(rc->frames[i].mask);
+    }
+    free(rc->frames);
+    rc->frames = NULL;
+    rc->steps = 0;
+}
+
+const RotFrame *rotcache_frame(const RotCache *rc, int degrees) {
+    degrees %= 360;
+    if (degrees < 0) degrees += 360;
+    int i = (degrees * rc->steps + 180) / 360;
+    return &rc->frames[i % rc->steps];
+}
+
+int rotcache_hit(const RotFrame *f, int x, int y) {
+    if (x < 0 || y < 0 || x >= f->surf->w || y >= f->surf->h) return 0;
+    return f->mask[y * f->surf->w + x];
+}
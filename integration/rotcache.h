@@ -0,0 +1,30 @@
+#ifndef ROTCACHE_H
+#define ROTCACHE_H
+
+#include <SDL/SDL.h>
+
+// Pre-rendered rotations of one sprite at `steps` evenly spaced angles.
+// Angles are clockwise on screen, in degrees. `steps` is rounded up to a
+// multiple of 4 so that 90, 180 and 270 are always exact, lossless frames.
+
+typedef struct {
+    SDL_Surface *surf;          // rotated sprite, transparent outside the image
+    Uint8 *mask;                // surf->w * surf->h bytes, 1 where opaque
+    int boxX, boxY, boxW, boxH; // tight collision box inside surf
+} RotFrame;
+
+typedef struct {
+    int steps;
+    RotFrame *frames;
+} RotCache;
+
+int  rotcache_init(RotCache *rc, SDL_Surface *src, int steps);
+void rotcache_free(RotCache *rc);
+
+// Nearest cached frame for an arbitrary angle
+const RotFrame *rotcache_frame(const RotCache *rc, int degrees);
+
+// Pixel test in frame-local coordinates, for checks finer than the box
+int rotcache_hit(const RotFrame *f, int x, int y);
+
+#endif
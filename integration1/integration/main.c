@@ -5,24 +5,30 @@
 #include <stdlib.h>
 #include <time.h>
 #include <stdio.h>
+#include <string.h>
+#include "savegame.h"
+#include "rewind.h"
 
 #define IDLE_FRAMES 4
 #define MOVE_FRAMES 4
 #define DEATH_FRAMES 4
 #define ENEMY_MAX_HEALTH 6
 #define HURT_FRAMES 1
-#define MAX_OBSTACLES 3
+#define AUTOSAVE_DELAY 30000   // ms entre deux sauvegardes automatiques
+#define REWIND_BUDGET (64 * 1024)
+#define REWIND_INTERVAL 2       // une image sur deux va dans l'historique
 
-// Structure pour sauvegarder l'état du jeu
+// Tout l'état simulé de l'arène, pour le retour arrière et la sauvegarde rapide
 typedef struct {
-    SDL_Rect posPlayer;
-    SDL_Rect posEnemy[2];
-    int enemyHealth[2];
-    bool isDying[2];
-    bool obstacleActive[MAX_OBSTACLES];
-    SDL_Rect barrierPos;
-    int barrierDirection;
-} GameState;
+    GameState saved;
+    int moveDirection[2];
+    int directionAnimationFrame[2];
+    bool isChangingDirection[2];
+    int deathFrame[2];
+    bool isHurt[2];
+    Uint32 hurtEndTime[2];
+    int currentFrame, frameDelay;
+} ArenaSnapshot;
 
 SDL_Surface* resizeImage(SDL_Surface* surface, int newWidth, int newHeight) {
     SDL_Surface* resized = SDL_CreateRGBSurface(SDL_SWSURFACE, newWidth, newHeight,
@@ -66,24 +72,6 @@ bool checkCollision(SDL_Rect a, SDL_Rect b) {
             a.y + a.h > b.y);
 }
 
-void saveGameState(const GameState *state) {
-    FILE *file = fopen("saved_game.dat", "wb");
-    if (file) {
-        fwrite(state, sizeof(GameState), 1, file);
-        fclose(file);
-    }
-}
-
-bool loadGameState(GameState *state) {
-    FILE *file = fopen("saved_game.dat", "rb");
-    if (file) {
-        fread(state, sizeof(GameState), 1, file);
-        fclose(file);
-        return true;
-    }
-    return false;
-}
-
 int main(int argc, char *argv[]) {
     SDL_Init(SDL_INIT_VIDEO);
     IMG_Init(IMG_INIT_PNG | IMG_INIT_JPG);
@@ -229,9 +217,14 @@ int main(int argc, char *argv[]) {
     float scaleY = (float)minimap->h / background->h;
     Uint32 blackColor = SDL_MapRGB(screen->format, 0, 0, 0);
 
-    // Charger l'état sauvegardé si disponible
+    // Charger la sauvegarde valide la plus récente, tous emplacements confondus
+    save_init();
     GameState savedState;
-    if (loadGameState(&savedState)) {
+    int saveSlot = 1;           // emplacement de la touche S, choisi avec F1..F3
+    Uint32 nextAutosave = SDL_GetTicks() + AUTOSAVE_DELAY;
+    int loadedSlot = save_latest(&savedState);
+    if (loadedSlot >= 0) {
+        if (loadedSlot != SAVE_AUTO_SLOT) saveSlot = loadedSlot;
         posPlayer = savedState.posPlayer;
         for (int i = 0; i < 2; i++) {
             posEnemy[i] = savedState.posEnemy[i];
@@ -245,7 +238,13 @@ int main(int argc, char *argv[]) {
         barrierDirection = savedState.barrierDirection;
     }
 
+    // Retour arrière en maintenant Effacement, sauvegarde et chargement rapides avec F5 et F9
+    Rewind history;
+    bool historyOk = rewind_init(&history, sizeof(ArenaSnapshot), REWIND_BUDGET, REWIND_INTERVAL) == 0;
+
     while (running) {
+        int saveTo = -1;
+        bool quickSave = false, quickLoad = false;
         while (SDL_PollEvent(&event)) {
             if (event.type == SDL_QUIT) {
                 running = false;
@@ -255,21 +254,86 @@ int main(int argc, char *argv[]) {
             }
             else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_s) {
                 // Touche S pour sauvegarder sans quitter
-                GameState currentState;
-                currentState.posPlayer = posPlayer;
-                for (int i = 0; i < 2; i++) {
-                    currentState.posEnemy[i] = posEnemy[i];
-                    currentState.enemyHealth[i] = enemyHealth[i];
-                    currentState.isDying[i] = isDying[i];
-                }
-                for (int i = 0; i < MAX_OBSTACLES; i++) {
-                    currentState.obstacleActive[i] = obstacleActive[i];
-                }
-                currentState.barrierPos = barrierPos;
-                currentState.barrierDirection = barrierDirection;
-                
-                saveGameState(&currentState);
+                saveTo = saveSlot;
+            }
+            else if (event.type == SDL_KEYDOWN && event.key.keysym.sym >= SDLK_F1 &&
+                     event.key.keysym.sym < SDLK_F1 + SAVE_SLOTS - 1) {
+                saveSlot = 1 + (event.key.keysym.sym - SDLK_F1);
+                printf("Emplacement de sauvegarde %d\n", saveSlot);
+            }
+            else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F5) {
+                quickSave = true;
+            }
+            else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F9) {
+                quickLoad = true;
+            }
+        }
+
+        // État complet au début de cette image
+        ArenaSnapshot snap;
+        memset(&snap, 0, sizeof(snap));
+        snap.saved.posPlayer = posPlayer;
+        for (int i = 0; i < 2; i++) {
+            snap.saved.posEnemy[i] = posEnemy[i];
+            snap.saved.enemyHealth[i] = enemyHealth[i];
+            snap.saved.isDying[i] = isDying[i];
+            snap.moveDirection[i] = moveDirection[i];
+            snap.directionAnimationFrame[i] = directionAnimationFrame[i];
+            snap.isChangingDirection[i] = isChangingDirection[i];
+            snap.deathFrame[i] = deathFrame[i];
+            snap.isHurt[i] = isHurt[i];
+            snap.hurtEndTime[i] = hurtEndTime[i];
+        }
+        for (int i = 0; i < MAX_OBSTACLES; i++) {
+            snap.saved.obstacleActive[i] = obstacleActive[i];
+        }
+        snap.saved.barrierPos = barrierPos;
+        snap.saved.barrierDirection = barrierDirection;
+        snap.currentFrame = currentFrame;
+        snap.frameDelay = frameDelay;
+
+        bool restore = false;
+        if (historyOk) {
+            if (SDL_GetKeyState(NULL)[SDLK_BACKSPACE]) {
+                // Une image de l'historique par image affichée : on remonte à vitesse double
+                restore = rewind_back(&history, 1, &snap) > 0;
+            } else if (quickLoad) {
+                restore = rewind_load_mark(&history, &snap) == 0;
+            } else {
+                rewind_tick(&history, &snap);
+            }
+            if (quickSave) rewind_mark(&history, &snap);
+        }
+        if (restore) {
+            posPlayer = snap.saved.posPlayer;
+            for (int i = 0; i < 2; i++) {
+                posEnemy[i] = snap.saved.posEnemy[i];
+                enemyHealth[i] = snap.saved.enemyHealth[i];
+                isDying[i] = snap.saved.isDying[i];
+                moveDirection[i] = snap.moveDirection[i];
+                directionAnimationFrame[i] = snap.directionAnimationFrame[i];
+                isChangingDirection[i] = snap.isChangingDirection[i];
+                deathFrame[i] = snap.deathFrame[i];
+                isHurt[i] = snap.isHurt[i];
+                hurtEndTime[i] = snap.hurtEndTime[i];
             }
+            for (int i = 0; i < MAX_OBSTACLES; i++) {
+                obstacleActive[i] = snap.saved.obstacleActive[i];
+            }
+            barrierPos = snap.saved.barrierPos;
+            barrierDirection = snap.saved.barrierDirection;
+            currentFrame = snap.currentFrame;
+            frameDelay = snap.frameDelay;
+        }
+
+        // Sauvegarde automatique, sauf si une sauvegarde manuelle part déjà
+        if (SDL_GetTicks() >= nextAutosave) {
+            if (saveTo < 0) saveTo = SAVE_AUTO_SLOT;
+            nextAutosave = SDL_GetTicks() + AUTOSAVE_DELAY;
+        }
+        if (saveTo >= 0) {
+            // Seule la copie dans le tampon se fait ici, le disque est sur un autre thread
+            save_request(saveTo, &snap.saved);
         }
 
         // [Reste du code de la boucle de jeu inchangé...]
@@ -417,6 +481,11 @@ int main(int argc, char *argv[]) {
     }
 
     // Nettoyage
+    save_shutdown();
+    if (historyOk) {
+        rewind_report(&history, stdout);
+        rewind_free(&history);
+    }
     for (int i = 0; i < MAX_OBSTACLES; i++) {
         SDL_FreeSurface(obstacles[i]);
     }
@@ -0,0 +1,304 @@
+#include "savegame.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SAVE_MAGIC "KBSV"
+#define SAVE_VERSION 1
+#define SAVE_HEADER 20          // magique, version, heure, taille, CRC
+
+// Étiquettes des blocs
+#define TAG_PLAYER "PLYR"
+#define TAG_ENEMIES "ENMY"
+#define TAG_OBSTACLES "OBST"
+#define TAG_BARRIER "BARR"
+
+typedef struct {
+    Uint8 data[SAVE_MAX_BYTES];
+    int size;
+    bool pending;
+} SaveJob;
+
+static SaveJob jobs[SAVE_SLOTS];
+static Uint32 crcTable[256];
+static SDL_Thread *writer = NULL;
+static SDL_mutex *lock = NULL;
+static SDL_cond *wake = NULL;
+static bool quitting = false;
+
+static void crcInit(void) {
+    for (Uint32 n = 0; n < 256; n++) {
+        Uint32 c = n;
+        for (int k = 0; k < 8; k++) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        crcTable[n] = c;
+    }
+}
+
+static Uint32 crc32(const Uint8 *p, int len) {
+    Uint32 c = 0xFFFFFFFFu;
+    for (int i = 0; i < len; i++) c = crcTable[(c ^ p[i]) & 0xFF] ^ (c >> 8);
+    return c ^ 0xFFFFFFFFu;
+}
+
+static void slotPath(char *out, size_t size, int slot, const char *suffix) {
+    if (slot == SAVE_AUTO_SLOT) snprintf(out, size, "save_auto.dat%s", suffix);
+    else snprintf(out, size, "save_%d.dat%s", slot, suffix);
+}
+
+// --- Écriture little-endian dans le tampon ---
+
+typedef struct {
+    Uint8 *p;
+    int size, cap;
+    int chunk;                  // début du bloc en cours
+} Writer;
+
+static void putU32(Writer *w, Uint32 v) {
+    if (w->size + 4 > w->cap) {
+        w->size = w->cap + 1;   // débordement, repéré à la fin
+        return;
+    }
+    Uint8 *d = w->p + w->size;
+    d[0] = v; d[1] = v >> 8; d[2] = v >> 16; d[3] = v >> 24;
+    w->size += 4;
+}
+
+static void putRect(Writer *w, SDL_Rect r) {
+    putU32(w, (Uint32)(Sint32)r.x);
+    putU32(w, (Uint32)(Sint32)r.y);
+    putU32(w, r.w);
+    putU32(w, r.h);
+}
+
+static void beginChunk(Writer *w, const char *tag) {
+    if (w->size + 8 > w->cap) {
+        w->size = w->cap + 1;
+        return;
+    }
+    memcpy(w->p + w->size, tag, 4);
+    w->size += 4;
+    w->chunk = w->size;
+    putU32(w, 0);               // taille, complétée par endChunk
+}
+
+static void endChunk(Writer *w) {
+    if (w->size > w->cap) return;
+    Uint32 len = w->size - w->chunk - 4;
+    Uint8 *d = w->p + w->chunk;
+    d[0] = len; d[1] = len >> 8; d[2] = len >> 16; d[3] = len >> 24;
+}
+
+static int serialize(const GameState *s, Uint8 *out, int cap) {
+    Writer w = {out, SAVE_HEADER, cap, 0};
+
+    beginChunk(&w, TAG_PLAYER);
+    putRect(&w, s->posPlayer);
+    endChunk(&w);
+
+    beginChunk(&w, TAG_ENEMIES);
+    putU32(&w, 2);
+    for (int i = 0; i < 2; i++) {
+        putRect(&w, s->posEnemy[i]);
+        putU32(&w, (Uint32)s->enemyHealth[i]);
+        putU32(&w, s->isDying[i]);
+    }
+    endChunk(&w);
+
+    beginChunk(&w, TAG_OBSTACLES);
+    putU32(&w, MAX_OBSTACLES);
+    for (int i = 0; i < MAX_OBSTACLES; i++) putU32(&w, s->obstacleActive[i]);
+    endChunk(&w);
+
+    beginChunk(&w, TAG_BARRIER);
+    putRect(&w, s->barrierPos);
+    putU32(&w, (Uint32)s->barrierDirection);
+    endChunk(&w);
+
+    if (w.size > cap) return -1;
+
+    // En-tête, une fois la taille et le CRC connus
+    int payload = w.size - SAVE_HEADER;
+    memcpy(out, SAVE_MAGIC, 4);
+    w.size = 4;
+    putU32(&w, SAVE_VERSION);
+    putU32(&w, (Uint32)time(NULL));
+    putU32(&w, payload);
+    putU32(&w, crc32(out + SAVE_HEADER, payload));
+    return SAVE_HEADER + payload;
+}
+
+// --- Lecture ---
+
+static Uint32 getU32(const Uint8 *d) {
+    return d[0] | (d[1] << 8) | (d[2] << 16) | ((Uint32)d[3] << 24);
+}
+
+static SDL_Rect getRect(const Uint8 *d) {
+    SDL_Rect r = {(Sint16)(Sint32)getU32(d), (Sint16)(Sint32)getU32(d + 4), (Uint16)getU32(d + 8), (Uint16)getU32(d + 12)};
+    return r;
+}
+
+static int parse(const Uint8 *p, int len, GameState *s) {
+    int found = 0;
+    while (len >= 8) {
+        Uint32 size = getU32(p + 4);
+        const Uint8 *d = p + 8;
+        if (size > (Uint32)(len - 8)) return -1;
+
+        // Les blocs inconnus sont ignorés, les connus doivent avoir la bonne taille
+        if (memcmp(p, TAG_PLAYER, 4) == 0) {
+            if (size != 16) return -1;
+            s->posPlayer = getRect(d);
+            found |= 1;
+        } else if (memcmp(p, TAG_ENEMIES, 4) == 0) {
+            if (size != 4 + 2 * 24 || getU32(d) != 2) return -1;
+            for (int i = 0; i < 2; i++) {
+                const Uint8 *e = d + 4 + i * 24;
+                s->posEnemy[i] = getRect(e);
+                s->enemyHealth[i] = (int)getU32(e + 16);
+                s->isDying[i] = getU32(e + 20) != 0;
+            }
+            found |= 2;
+        } else if (memcmp(p, TAG_OBSTACLES, 4) == 0) {
+            if (size != 4 + MAX_OBSTACLES * 4 || getU32(d) != MAX_OBSTACLES) return -1;
+            for (int i = 0; i < MAX_OBSTACLES; i++) s->obstacleActive[i] = getU32(d + 4 + i * 4) != 0;
+            found |= 4;
+        } else if (memcmp(p, TAG_BARRIER, 4) == 0) {
+            if (size != 20) return -1;
+            s->barrierPos = getRect(d);
+            s->barrierDirection = (int)getU32(d + 16) < 0 ? -1 : 1;
+            found |= 8;
+        }
+        p += 8 + size;
+        len -= 8 + size;
+    }
+    return found == 15 ? 0 : -1;
+}
+
+int save_load(int slot, GameState *state, Uint32 *savedAt) {
+    if (slot < 0 || slot >= SAVE_SLOTS) return -1;
+    char path[64];
+    slotPath(path, sizeof(path), slot, "");
+    FILE *f = fopen(path, "rb");
+    if (!f) return -1;
+
+    // L'en-tête suffit pour écarter un fichier d'un autre format ou version
+    Uint8 buf[SAVE_MAX_BYTES];
+    int ok = fread(buf, 1, SAVE_HEADER, f) == SAVE_HEADER && memcmp(buf, SAVE_MAGIC, 4) == 0 &&
+             getU32(buf + 4) == SAVE_VERSION && getU32(buf + 12) <= SAVE_MAX_BYTES - SAVE_HEADER;
+    int payload = ok ? (int)getU32(buf + 12) : 0;
+    ok = ok && fread(buf + SAVE_HEADER, 1, payload, f) == (size_t)payload && fgetc(f) == EOF;
+    fclose(f);
+    if (!ok || crc32(buf + SAVE_HEADER, payload) != getU32(buf + 16)) return -1;
+
+    GameState loaded;
+    if (parse(buf + SAVE_HEADER, payload, &loaded) != 0) return -1;
+    *state = loaded;
+    if (savedAt) *savedAt = getU32(buf + 8);
+    return 0;
+}
+
+int save_latest(GameState *state) {
+    int best = -1;
+    Uint32 bestTime = 0;
+    for (int slot = 0; slot < SAVE_SLOTS; slot++) {
+        GameState s;
+        Uint32 t;
+        if (save_load(slot, &s, &t) == 0 && (best < 0 || t >= bestTime)) {
+            best = slot;
+            bestTime = t;
+            *state = s;
+        }
+    }
+    return best;
+}
+
+// --- Thread d'écriture ---
+
+static bool writeFile(int slot, const Uint8 *data, int size) {
+    char path[64], tmp[64];
+    slotPath(path, sizeof(path), slot, "");
+    slotPath(tmp, sizeof(tmp), slot, ".tmp");
+
+    FILE *f = fopen(tmp, "wb");
+    if (!f) return false;
+    bool ok = fwrite(data, 1, size, f) == (size_t)size && fflush(f) == 0 && fsync(fileno(f)) == 0;
+    ok = fclose(f) == 0 && ok;
+    if (ok && rename(tmp, path) == 0) return true;
+    remove(tmp);
+    return false;
+}
+
+static int writerMain(void *arg) {
+    static Uint8 data[SAVE_MAX_BYTES];
+    (void)arg;
+
+    SDL_mutexP(lock);
+    for (;;) {
+        int slot = 0;
+        while (slot < SAVE_SLOTS && !jobs[slot].pending) slot++;
+        if (slot == SAVE_SLOTS) {
+            if (quitting) break;
+            SDL_CondWait(wake, lock);
+            continue;
+        }
+
+        // Copie, puis écriture sans bloquer le jeu
+        int size = jobs[slot].size;
+        memcpy(data, jobs[slot].data, size);
+        jobs[slot].pending = false;
+        SDL_mutexV(lock);
+
+        if (!writeFile(slot, data, size)) printf("Échec de la sauvegarde (emplacement %d)\n", slot);
+
+        SDL_mutexP(lock);
+    }
+    SDL_mutexV(lock);
+    return 0;
+}
+
+int save_init(void) {
+    crcInit();
+    lock = SDL_CreateMutex();
+    wake = SDL_CreateCond();
+    quitting = false;
+    writer = lock && wake ? SDL_CreateThread(writerMain, NULL) : NULL;
+    if (!writer) {
+        printf("Impossible de lancer le thread de sauvegarde : %s\n", SDL_GetError());
+        return -1;
+    }
+    return 0;
+}
+
+void save_shutdown(void) {
+    if (!writer) return;
+    SDL_mutexP(lock);
+    quitting = true;
+    SDL_CondSignal(wake);
+    SDL_mutexV(lock);
+    SDL_WaitThread(writer, NULL);
+    writer = NULL;
+    SDL_DestroyCond(wake);
+    SDL_DestroyMutex(lock);
+}
+
+int save_request(int slot, const GameState *state) {
+    if (slot < 0 || slot >= SAVE_SLOTS) return -1;
+
+    // Sérialisé hors verrou : le thread ne touche jamais à ce tampon
+    Uint8 data[SAVE_MAX_BYTES];
+    int size = serialize(state, data, sizeof(data));
+    if (size < 0) return -1;
+
+    // Sans thread, on écrit tout de suite plutôt que de perdre la sauvegarde
+    if (!writer) return writeFile(slot, data, size) ? 0 : -1;
+
+    SDL_mutexP(lock);
+    memcpy(jobs[slot].data, data, size);
+    jobs[slot].size = size;
+    jobs[slot].pending = true;
+    SDL_CondSignal(wake);
+    SDL_mutexV(lock);
+    return 0;
+}
@@ -0,0 +1,43 @@
+#ifndef SAVEGAME_H
+#define SAVEGAME_H
+
+#include <SDL/SDL.h>
+#include <stdbool.h>
+
+#define MAX_OBSTACLES 3
+
+// Sauvegardes de l'arène. Le fichier est un format binaire versionné :
+// en-tête (magique, version, taille, CRC32) puis des blocs étiquetés, tous
+// les entiers en little-endian. La sérialisation se fait sur le thread du
+// jeu dans un tampon fixe ; l'écriture sur disque se fait sur un thread à
+// part, dans un fichier temporaire renommé ensuite, pour qu'un fichier
+// existant ne soit jamais à moitié écrit.
+
+#define SAVE_SLOTS 4            // emplacement 0 : sauvegarde automatique
+#define SAVE_AUTO_SLOT 0
+#define SAVE_MAX_BYTES 512
+
+// Structure pour sauvegarder l'état du jeu
+typedef struct {
+    SDL_Rect posPlayer;
+    SDL_Rect posEnemy[2];
+    int enemyHealth[2];
+    bool isDying[2];
+    bool obstacleActive[MAX_OBSTACLES];
+    SDL_Rect barrierPos;
+    int barrierDirection;
+} GameState;
+
+int  save_init(void);
+// Attend la fin des écritures en cours avant d'arrêter le thread
+void save_shutdown(void);
+// Sérialise tout de suite et laisse l'écriture au thread ; une demande
+// pour un emplacement encore en attente remplace la précédente
+int  save_request(int slot, const GameState *state);
+// Lecture synchrone ; -1 si le fichier manque, est corrompu ou d'une
+// autre version. `savedAt` (peut être NULL) reçoit l'heure de sauvegarde.
+int  save_load(int slot, GameState *state, Uint32 *savedAt);
+// Emplacement valide le plus récent, ou -1
+int  save_latest(GameState *state);
+
+#endif
@@ -8,6 +8,9 @@
 #include <sys/wait.h>
 #include <string.h>
 #include <errno.h>
+#include "highlight.h"
+#include "sfx.h"
+#include "stream.h"
 
 // Function to create fade transition between two surfaces
 void fadeTransition(SDL_Surface* screen, SDL_Surface* from, SDL_Surface* to, int duration_ms) {
@@ -26,8 +29,10 @@ void fadeTransition(SDL_Surface* screen, SDL_Surface* from, SDL_Surface* to, int
     }
 }
 
-// Function to start the game (launch prog from integration directory)
-void startGame(SDL_Surface* screen, SDL_Surface* menu4) {
+// Function to start the game (launch prog from integration directory). Two
+// players go to the networked arena instead; started twice on one machine,
+// the two copies find each other on 127.0.0.1.
+void startGame(SDL_Surface* screen, SDL_Surface* menu4, int multi) {
     // Create fade transition to menu4.png
     SDL_Surface* current = SDL_GetVideoSurface();
     fadeTransition(screen, current, menu4, 500);
@@ -35,11 +40,12 @@ void startGame(SDL_Surface* screen, SDL_Surface* menu4) {
     // Launch game executable
     pid_t pid = fork();
     if (pid == 0) {
-        if(chdir("integration") != 0) {
+        if(chdir(multi ? "../integration" : "integration") != 0) {
             printf("Failed to change directory: %s\n", strerror(errno));
             exit(1);
         }
-        execl("./prog", "./prog", NULL);
+        if (multi) execl("./prog", "./prog", "--netplay", NULL);
+        else execl("./prog", "./prog", NULL);
         printf("Failed to execute game: %s\n", strerror(errno));
         exit(1);
     } 
@@ -69,9 +75,10 @@ int main(int argc, char** argv) {
     int show_new_buttons = 0;
     int bouton_hover = -1;
     int avatar_selectionne = 0;
+    int multi = 0;
 
     SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO);
-    Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 1024);
+    Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, SFX_BUFFER);
     TTF_Init();
 
     ecran = SDL_SetVideoMode(1024, 1024, 32, SDL_HWSURFACE | SDL_DOUBLEBUF);
@@ -84,14 +91,16 @@ int main(int argc, char** argv) {
     btn_avatar1 = IMG_Load("avatar1.jpeg");
     btn_avatar2 = IMG_Load("avatar2.jpeg");
     btn_valider = IMG_Load("valider.jpeg");
-    gro_mono = IMG_Load("gromono.jpeg");
-    gro_multi = IMG_Load("gromulti.jpeg");
-    gro_retour = IMG_Load("groretour.jpeg");
-    gro_avatar1 = IMG_Load("groavatar1.jpeg");
-    gro_avatar2 = IMG_Load("groavatar2.jpeg");
-    gro_valider = IMG_Load("grovalider.jpeg");
     menu4 = IMG_Load("menu4.png");  // Load the final menu image
-    
+
+    // Enlarged hover images are generated from the buttons, not loaded
+    gro_mono = highlight_make(btn_mono, HIGHLIGHT_SCALE);
+    gro_multi = highlight_make(btn_multi, HIGHLIGHT_SCALE);
+    gro_retour = highlight_make(btn_retour, HIGHLIGHT_SCALE);
+    gro_avatar1 = highlight_make(btn_avatar1, HIGHLIGHT_SCALE);
+    gro_avatar2 = highlight_make(btn_avatar2, HIGHLIGHT_SCALE);
+    gro_valider = highlight_make(btn_valider, HIGHLIGHT_SCALE);
+
     // Set positions
     positionimage.x = 0; positionimage.y = 0;
     pos_mono.x = 100; pos_mono.y = 300;
@@ -101,9 +110,21 @@ int main(int argc, char** argv) {
     pos_avatar2.x = 600; pos_avatar2.y = 300;
     pos_valider.x = 350; pos_valider.y = 570;
     
-    Mix_Music *musique = Mix_LoadMUS("palestine.mp3");
-    Mix_Chunk *son_hover = Mix_LoadWAV("button_hover.wav");
-    Mix_PlayMusic(musique, -1);
+    // The music is decoded on its own thread; SDL_mixer's player is the fallback
+    MusicStream flux;
+    Mix_Music *musique = NULL;
+    if (stream_open(&flux, "palestine.mp3", 1) == 0) {
+        stream_hook(&flux);
+    } else {
+        musique = Mix_LoadMUS("palestine.mp3");
+        Mix_PlayMusic(musique, -1);
+    }
+
+    // Hover sounds go through the low-latency voice pool; sweeping across
+    // buttons faster than 40 ms apart plays a single sound
+    SfxEngine sfx;
+    sfx_init(&sfx);
+    int son_hover = sfx_load(&sfx, "button_hover.wav", 1, 40);
 
     while (quitter) {
         SDL_FillRect(ecran, NULL, SDL_MapRGB(ecran->format, 0, 0, 0));
@@ -134,7 +155,7 @@ int main(int argc, char** argv) {
                 btn_surface = gro_mono;
                 btn_rect = &pos_mono;
                 if (bouton_hover != 1) {
-                    Mix_PlayChannel(-1, son_hover, 0);
+                    sfx_play(&sfx, son_hover);
                     bouton_hover = 1;
                 }
             } 
@@ -143,7 +164,7 @@ int main(int argc, char** argv) {
                 btn_surface = gro_multi;
                 btn_rect = &pos_multi;
                 if (bouton_hover != 2) {
-                    Mix_PlayChannel(-1, son_hover, 0);
+                    sfx_play(&sfx, son_hover);
                     bouton_hover = 2;
                 }
             }
@@ -152,7 +173,7 @@ int main(int argc, char** argv) {
                 btn_surface = gro_retour;
                 btn_rect = &pos_retour;
                 if (bouton_hover != 3) {
-                    Mix_PlayChannel(-1, son_hover, 0);
+                    sfx_play(&sfx, son_hover);
                     bouton_hover = 3;
                 }
             }
@@ -163,7 +184,7 @@ int main(int argc, char** argv) {
                 btn_surface = gro_avatar1;
                 btn_rect = &pos_avatar1;
                 if (bouton_hover != 4) {
-                    Mix_PlayChannel(-1, son_hover, 0);
+                    sfx_play(&sfx, son_hover);
                     bouton_hover = 4;
                 }
             } 
@@ -172,7 +193,7 @@ int main(int argc, char** argv) {
                 btn_surface = gro_avatar2;
                 btn_rect = &pos_avatar2;
                 if (bouton_hover != 5) {
-                    Mix_PlayChannel(-1, son_hover, 0);
+                    sfx_play(&sfx, son_hover);
                     bouton_hover = 5;
                 }
             } 
@@ -181,7 +202,7 @@ int main(int argc, char** argv) {
                 btn_surface = gro_valider;
                 btn_rect = &pos_valider;
                 if (bouton_hover != 6) {
-                    Mix_PlayChannel(-1, son_hover, 0);
+                    sfx_play(&sfx, son_hover);
                     bouton_hover = 6;
                 }
             }
@@ -190,7 +211,7 @@ int main(int argc, char** argv) {
                 btn_surface = gro_retour;
                 btn_rect = &pos_retour;
                 if (bouton_hover != 7) {
-                    Mix_PlayChannel(-1, son_hover, 0);
+                    sfx_play(&sfx, son_hover);
                     bouton_hover = 7;
                 }
             }
@@ -214,12 +235,14 @@ int main(int argc, char** argv) {
                                 event.button.y >= pos_mono.y && event.button.y <= pos_mono.y + btn_mono->h) {
                                 show_initial_buttons = 0;
                                 show_new_buttons = 1;
+                                multi = 0;
                             }
 
                             if (event.button.x >= pos_multi.x && event.button.x <= pos_multi.x + btn_multi->w &&
                                 event.button.y >= pos_multi.y && event.button.y <= pos_multi.y + btn_multi->h) {
                                 show_initial_buttons = 0;
                                 show_new_buttons = 1;
+                                multi = 1;
                             }
                         }
 
@@ -237,7 +260,7 @@ int main(int argc, char** argv) {
                                 event.button.y >= pos_valider.y && event.button.y <= pos_valider.y + btn_valider->h) {
                                 if (avatar_selectionne != 0) {
                                     printf("Avatar %d sélectionné et validé\n", avatar_selectionne);
-                                    startGame(ecran, menu4);
+                                    startGame(ecran, menu4, multi);
                                     quitter = 0;
                                 }
                             }
@@ -278,7 +301,11 @@ int main(int argc, char** argv) {
     SDL_FreeSurface(image);
     SDL_FreeSurface(menu4);
     
-    Mix_FreeChunk(son_hover);
+    sfx_report(&sfx, stdout);
+    sfx_shutdown(&sfx);
+    stream_unhook();
+    stream_report(&flux, "palestine.mp3", stdout);
+    stream_close(&flux);
     Mix_FreeMusic(musique);
     Mix_CloseAudio();
     
@@ -28,7 +28,7 @@ int init(AppState *state) {
         return -1;
     }
 
-    state->screen = SDL_SetVideoMode(SCREEN_WIDTH, SCREEN_HEIGHT, 32, SDL_SWSURFACE);
+    state->screen = SDL_SetVideoMode(SCREEN_WIDTH, SCREEN_HEIGHT, 32, SDL_SWSURFACE | SDL_RESIZABLE);
     if (!state->screen) {
         printf("Erreur SDL_SetVideoMode: %s\n", SDL_GetError());
         return -1;
@@ -39,7 +39,7 @@ int init(AppState *state) {
         return -1;
     }
 
-    if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0) {
+    if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, SFX_BUFFER) < 0) {
         printf("Erreur Mix_OpenAudio: %s\n", IMG_GetError());
         return -1;
     }
@@ -58,12 +58,11 @@ int init(AppState *state) {
     state->buttons[4] = IMG_Load("images/return.png");
     state->buttons[5] = IMG_Load("images/display mode.png");
     state->buttons[6] = IMG_Load("images/volume.png");
-    state->buttonsHover[0] = IMG_Load("images/rightH.png");
-    state->buttonsHover[1] = IMG_Load("images/leftH.png");
-    state->buttonsHover[2] = IMG_Load("images/fullscreenH.png");
-    state->buttonsHover[3] = IMG_Load("images/normalH.png");
-    state->buttonsHover[4] = IMG_Load("images/returnH.png");
 
+    // Les images de survol sont générées une fois à partir des boutons
+    for (int i = 0; i < 5; i++) {
+        state->buttonsHover[i] = highlight_make(state->buttons[i], HIGHLIGHT_BRIGHTEN);
+    }
 
     for (int i = 0; i < 5; i++) {
         if (!state->buttons[i] || !state->buttonsHover[i]) {
@@ -91,26 +90,41 @@ int init(AppState *state) {
         state->currentButtons[i] = state->buttons[i];
     }
 
-    state->backgroundMusic = Mix_LoadMUS("background.mp3");
-    if (!state->backgroundMusic) {
-        printf("Erreur chargement musique: %s\n", Mix_GetError());
+    presentationRebuild(state);
+
+    // Musique en flux : le rappel audio ne fait que copier depuis l'anneau
+    if (stream_open(&state->music, "background.mp3", 1) != 0) {
+        state->backgroundMusic = Mix_LoadMUS("background.mp3");
+        if (!state->backgroundMusic) {
+            printf("Erreur chargement musique: %s\n", Mix_GetError());
+            return -1;
+        }
+    }
+
+    // Petit tampon audio et voix pré-décodées : le son suit la souris
+    if (sfx_init(&state->sfx) != 0) {
         return -1;
     }
 
-    state->buttonClickSound = Mix_LoadWAV("clic.wav");
-    if (!state->buttonClickSound) {
+    // Le clic passe avant le survol ; les survols rapprochés n'en font qu'un
+    state->clickSound = sfx_load(&state->sfx, "clic.wav", 2, 0);
+    if (state->clickSound < 0) {
         printf("Erreur chargement son de clic: %s\n", Mix_GetError());
         return -1;
     }
 
-    state->buttonHoverSound = Mix_LoadWAV("hover.wav");
-    if (!state->buttonHoverSound) {
+    state->hoverSound = sfx_load(&state->sfx, "hover.wav", 1, 40);
+    if (state->hoverSound < 0) {
         printf("Erreur chargement son de survol: %s\n", Mix_GetError());
         return -1;
     }
 
-    Mix_PlayMusic(state->backgroundMusic, -1);
-    Mix_VolumeMusic(MIX_MAX_VOLUME * state->currentVolume / MAX_VOLUME);
+    if (state->backgroundMusic) {
+        Mix_PlayMusic(state->backgroundMusic, -1);
+    } else {
+        stream_hook(&state->music);
+    }
+    applyVolume(state);
 
     return 0;
 }
@@ -127,7 +141,15 @@ void setButtonPositions(AppState *state) {
 
 void updateVolumeBar(AppState *state) {
     SDL_Rect rect = {700, 200, 300, 80};
-    SDL_BlitSurface(state->volumeBar[state->currentVolume], NULL, state->screen, &rect);
+    SDL_Rect dst = logicalToScreen(state, rect);
+    SDL_BlitSurface(state->scaledVolumeBar[state->currentVolume], NULL, state->screen, &dst);
+}
+
+// Le volume du flux est appliqué par notre rappel, pas par SDL_mixer
+void applyVolume(AppState *state) {
+    int volume = MIX_MAX_VOLUME * state->currentVolume / MAX_VOLUME;
+    Mix_VolumeMusic(volume);
+    state->music.volume = volume;
 }
 
 void handleEvents(AppState *state) {
@@ -142,6 +164,7 @@ void handleEvents(AppState *state) {
         }
 
         SDL_GetMouseState(&x, &y);
+        screenToLogical(state, &x, &y);
 
         switch (event.type) {
             case SDL_MOUSEBUTTONDOWN:
@@ -150,10 +173,10 @@ void handleEvents(AppState *state) {
                         y >= state->buttonRects[i].y && y <= state->buttonRects[i].y + 80) {
                         if (i == 0 && state->currentVolume < MAX_VOLUME) {
                             state->currentVolume++;
-                            Mix_VolumeMusic(MIX_MAX_VOLUME * state->currentVolume / MAX_VOLUME);
+                            applyVolume(state);
                         } else if (i == 1 && state->currentVolume > 0) {
                             state->currentVolume--;
-                            Mix_VolumeMusic(MIX_MAX_VOLUME * state->currentVolume / MAX_VOLUME);
+                            applyVolume(state);
                         } else if (i == 2) {
                             toggleFullscreen(state, 1); // Switch to fullscreen
                         } else if (i == 3) {
@@ -161,7 +184,7 @@ void handleEvents(AppState *state) {
                         } else if (i == 4) {
                             state->isInOptionsMenu = 0;
                         }
-                        Mix_PlayChannel(1, state->buttonClickSound, 0);
+                        sfx_play(&state->sfx, state->clickSound);
                     }
                 }
                 break;
@@ -172,7 +195,7 @@ void handleEvents(AppState *state) {
                         y >= state->buttonRects[i].y && y <= state->buttonRects[i].y + 80) {
                         state->currentButtons[i] = state->buttonsHover[i];
                         if (lastHoveredButton != i) {
-                            Mix_PlayChannel(-1, state->buttonHoverSound, 0);
+                            sfx_play(&state->sfx, state->hoverSound);
                             lastHoveredButton = i;
                         }
                     } else {
@@ -185,21 +208,21 @@ void handleEvents(AppState *state) {
                 if (event.key.keysym.sym == SDLK_PLUS || event.key.keysym.sym == SDLK_KP_PLUS|| (event.key.keysym.sym == SDLK_EQUALS&&event.key.keysym.mod==KMOD_LSHIFT)) {
                     if (state->currentVolume < MAX_VOLUME) {
                         state->currentVolume++;
-                        Mix_VolumeMusic(MIX_MAX_VOLUME * state->currentVolume / MAX_VOLUME);
-                        Mix_PlayChannel(1, state->buttonClickSound, 0);
+                        applyVolume(state);
+                        sfx_play(&state->sfx, state->clickSound);
                     }
                 }
 
                 if (event.key.keysym.sym == SDLK_MINUS || event.key.keysym.sym == SDLK_KP_MINUS) {
                     if (state->currentVolume > 0) {
                         state->currentVolume--;
-                        Mix_VolumeMusic(MIX_MAX_VOLUME * state->currentVolume / MAX_VOLUME);
-                        Mix_PlayChannel(1, state->buttonClickSound, 0);
+                        applyVolume(state);
+                        sfx_play(&state->sfx, state->clickSound);
                     }
                 }
                 if (event.key.keysym.sym == SDLK_ESCAPE) {
                     state->isInOptionsMenu = 0;
-                    Mix_PlayChannel(1, state->buttonClickSound, 0);
+                    sfx_play(&state->sfx, state->clickSound);
                 }
                 break;
 
@@ -207,57 +230,53 @@ void handleEvents(AppState *state) {
                 if (state->isFullscreen) {
                     state->screen = SDL_SetVideoMode(event.resize.w, event.resize.h, 32, SDL_SWSURFACE | SDL_FULLSCREEN);
                 } else {
-                    state->screen = SDL_SetVideoMode(event.resize.w, event.resize.h, 32, SDL_SWSURFACE);
+                    state->screen = SDL_SetVideoMode(event.resize.w, event.resize.h, 32, SDL_SWSURFACE | SDL_RESIZABLE);
                 }
                 if (!state->screen) {
                     printf("Erreur SDL_SetVideoMode: %s\n", SDL_GetError());
                     return;
                 }
+                presentationRebuild(state);
                 break;
         }
     }
 }
 
 void toggleFullscreen(AppState *state, int fullscreen) {
-    Uint32 flags = SDL_SWSURFACE | SDL_DOUBLEBUF;
+    // Plein écran à la résolution native du bureau, fenêtre en 1280x720
     if (fullscreen) {
-        flags |= SDL_FULLSCREEN;
+        state->screen = SDL_SetVideoMode(0, 0, 32, SDL_SWSURFACE | SDL_DOUBLEBUF | SDL_FULLSCREEN);
+    } else {
+        state->screen = SDL_SetVideoMode(SCREEN_WIDTH, SCREEN_HEIGHT, 32, SDL_SWSURFACE | SDL_DOUBLEBUF | SDL_RESIZABLE);
     }
-    state->screen = SDL_SetVideoMode(0, 0, 32, flags);
     if (!state->screen) {
         printf("Erreur SDL_SetVideoMode: %s\n", SDL_GetError());
         return;
     }
     state->isFullscreen = fullscreen;
 
-    // Clear the screen
-    SDL_FillRect(state->screen, NULL, 0);
-
-    // Draw the background
-    SDL_BlitSurface(state->background, NULL, state->screen, NULL);
-
-    // Draw the buttons
-    for (int i = 0; i < 7; i++) {
-        SDL_BlitSurface(state->currentButtons[i], NULL, state->screen, &state->buttonRects[i]);
-    }
-
-    // Update the volume bar
-    updateVolumeBar(state);
-
-    // Update the screen
-    SDL_Flip(state->screen);
+    // Les images sont remises à l'échelle une fois pour ce mode
+    presentationRebuild(state);
+    render(state);
 }
 
 void cleanup(AppState *state) {
+    presentationFree(state);
     SDL_FreeSurface(state->background);
     for (int i = 0; i < 7; i++) {
         SDL_FreeSurface(state->buttons[i]);
+    }
+    // Seuls les 5 premiers boutons ont une image de survol
+    for (int i = 0; i < 5; i++) {
         SDL_FreeSurface(state->buttonsHover[i]);
     }
 
+    stream_unhook();
+    stream_report(&state->music, "background.mp3", stdout);
+    stream_close(&state->music);
     Mix_FreeMusic(state->backgroundMusic);
-    Mix_FreeChunk(state->buttonClickSound);
-    Mix_FreeChunk(state->buttonHoverSound);
+    sfx_report(&state->sfx, stdout);
+    sfx_shutdown(&state->sfx);
     for (int i = 0; i <= MAX_VOLUME; i++) {
         SDL_FreeSurface(state->volumeBar[i]);
     }
@@ -267,15 +286,18 @@ void cleanup(AppState *state) {
 }
 
 void render(AppState *state) {
-    // Clear the screen
+    // Clear the screen (also the letterbox bars)
     SDL_FillRect(state->screen, NULL, 0);
 
     // Draw the background
-    SDL_BlitSurface(state->background, NULL, state->screen, NULL);
+    SDL_Rect viewport = state->viewport;
+    SDL_BlitSurface(state->scaledBackground, NULL, state->screen, &viewport);
 
     // Draw the buttons
     for (int i = 0; i < 7; i++) {
-        SDL_BlitSurface(state->currentButtons[i], NULL, state->screen, &state->buttonRects[i]);
+        int hovered = state->currentButtons[i] == state->buttonsHover[i];
+        SDL_Rect dst = logicalToScreen(state, state->buttonRects[i]);
+        SDL_BlitSurface(hovered ? state->scaledButtonsHover[i] : state->scaledButtons[i], NULL, state->screen, &dst);
     }
 
     // Update the volume bar
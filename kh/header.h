@@ -6,6 +6,9 @@
 #include <SDL/SDL_mixer.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include "highlight.h"
+#include "sfx.h"
+#include "stream.h"
 
 // Définir la taille maximale du volume
 #define MAX_VOLUME 5
@@ -27,19 +30,32 @@ typedef struct {
     SDL_Surface *buttonsHover[7];
     SDL_Surface *currentButtons[7];
     SDL_Surface *volumeBar[MAX_VOLUME + 1];
-    SDL_Rect buttonRects[7];
-    Mix_Music *backgroundMusic;
-    Mix_Chunk *buttonClickSound;
-    Mix_Chunk *buttonHoverSound;
+    SDL_Rect buttonRects[7];    // en coordonnées logiques (1280x720)
+    // Présentation : images mises à l'échelle pour le mode vidéo actif
+    int scale;                  // sortie / logique, virgule fixe 16.16
+    SDL_Rect viewport;          // zone de l'écran couverte par l'image logique
+    SDL_Surface *scaledBackground;
+    SDL_Surface *scaledButtons[7];
+    SDL_Surface *scaledButtonsHover[7];
+    SDL_Surface *scaledVolumeBar[MAX_VOLUME + 1];
+    MusicStream music;          // décodée sur son propre thread
+    Mix_Music *backgroundMusic; // repli si le flux ne s'ouvre pas
+    SfxEngine sfx;
+    int clickSound, hoverSound;     // identifiants dans sfx
 } AppState;
 
 // Déclarations des fonctions
 int init(AppState *state);
 void updateVolumeBar(AppState *state);
+void applyVolume(AppState *state);
 void handleEvents(AppState *state);
 void cleanup(AppState *state);
 void toggleFullscreen(AppState *state, int fullscreen);
 void setButtonPositions(AppState *state);
 void render(AppState *state);
+void presentationRebuild(AppState *state);
+void presentationFree(AppState *state);
+SDL_Rect logicalToScreen(const AppState *state, SDL_Rect r);
+void screenToLogical(const AppState *state, int *x, int *y);
 
 #endif
@@ -0,0 +1,100 @@
+#include "header.h"
+
+// Couche de présentation : tout le menu est pensé en 1280x720 (résolution
+// logique). À chaque changement de mode, les images sont redimensionnées une
+// seule fois pour la sortie active, avec des bandes noires si le format
+// diffère. En 1280x720, les images d'origine sont utilisées telles quelles.
+
+static SDL_Surface *scaleAsset(SDL_Surface *src, int scale) {
+    if (!src) return NULL;
+    if (scale == 1 << 16) return src;
+
+    int w = (int)(((Sint64)src->w * scale) >> 16);
+    int h = (int)(((Sint64)src->h * scale) >> 16);
+    if (w < 1) w = 1;
+    if (h < 1) h = 1;
+
+    SDL_PixelFormat *f = src->format;
+    SDL_Surface *tmp = SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, f->BitsPerPixel,
+                                            f->Rmask, f->Gmask, f->Bmask, f->Amask);
+    if (!tmp) return NULL;
+    SDL_SoftStretch(src, NULL, tmp, NULL);
+
+    // Converti au format de l'écran pour que le blit reste rapide
+    SDL_Surface *out = f->Amask ? SDL_DisplayFormatAlpha(tmp) : SDL_DisplayFormat(tmp);
+    if (out) {
+        SDL_FreeSurface(tmp);
+        return out;
+    }
+    return tmp;
+}
+
+static void freeAsset(SDL_Surface *scaled, SDL_Surface *original) {
+    if (scaled && scaled != original) SDL_FreeSurface(scaled);
+}
+
+void presentationFree(AppState *state) {
+    freeAsset(state->scaledBackground, state->background);
+    state->scaledBackground = NULL;
+    for (int i = 0; i < 7; i++) {
+        freeAsset(state->scaledButtons[i], state->buttons[i]);
+        freeAsset(state->scaledButtonsHover[i], state->buttonsHover[i]);
+        state->scaledButtons[i] = state->scaledButtonsHover[i] = NULL;
+    }
+    for (int i = 0; i <= MAX_VOLUME; i++) {
+        freeAsset(state->scaledVolumeBar[i], state->volumeBar[i]);
+        state->scaledVolumeBar[i] = NULL;
+    }
+}
+
+// À appeler après chaque SDL_SetVideoMode, jamais pendant le rendu
+void presentationRebuild(AppState *state) {
+    presentationFree(state);
+
+    int outW = state->screen->w, outH = state->screen->h;
+    int scaleX = (int)(((Sint64)outW << 16) / SCREEN_WIDTH);
+    int scaleY = (int)(((Sint64)outH << 16) / SCREEN_HEIGHT);
+    state->scale = scaleX < scaleY ? scaleX : scaleY;
+
+    state->viewport.w = (Uint16)(((Sint64)SCREEN_WIDTH * state->scale) >> 16);
+    state->viewport.h = (Uint16)(((Sint64)SCREEN_HEIGHT * state->scale) >> 16);
+    state->viewport.x = (Sint16)((outW - state->viewport.w) / 2);
+    state->viewport.y = (Sint16)((outH - state->viewport.h) / 2);
+
+    // Le fond couvre exactement la zone logique, sans écart d'arrondi
+    if (state->scale == 1 << 16) {
+        state->scaledBackground = state->background;
+    } else {
+        SDL_PixelFormat *f = state->background->format;
+        SDL_Surface *tmp = SDL_CreateRGBSurface(SDL_SWSURFACE, state->viewport.w, state->viewport.h,
+                                                f->BitsPerPixel, f->Rmask, f->Gmask, f->Bmask, f->Amask);
+        if (tmp) {
+            SDL_SoftStretch(state->background, NULL, tmp, NULL);
+            state->scaledBackground = SDL_DisplayFormat(tmp);
+            if (state->scaledBackground) SDL_FreeSurface(tmp);
+            else state->scaledBackground = tmp;
+        }
+    }
+
+    for (int i = 0; i < 7; i++) {
+        state->scaledButtons[i] = scaleAsset(state->buttons[i], state->scale);
+        state->scaledButtonsHover[i] = scaleAsset(state->buttonsHover[i], state->scale);
+    }
+    for (int i = 0; i <= MAX_VOLUME; i++) {
+        state->scaledVolumeBar[i] = scaleAsset(state->volumeBar[i], state->scale);
+    }
+}
+
+SDL_Rect logicalToScreen(const AppState *state, SDL_Rect r) {
+    int x0 = (int)(((Sint64)r.x * state->scale) >> 16);
+    int y0 = (int)(((Sint64)r.y * state->scale) >> 16);
+    int x1 = (int)(((Sint64)(r.x + r.w) * state->scale) >> 16);
+    int y1 = (int)(((Sint64)(r.y + r.h) * state->scale) >> 16);
+    SDL_Rect out = {state->viewport.x + x0, state->viewport.y + y0, x1 - x0, y1 - y0};
+    return out;
+}
+
+void screenToLogical(const AppState *state, int *x, int *y) {
+    *x = (int)(((Sint64)(*x - state->viewport.x) << 16) / state->scale);
+    *y = (int)(((Sint64)(*y - state->viewport.y) << 16) / state->scale);
+}
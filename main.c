@@ -7,9 +7,16 @@
 #include <sys/wait.h>
 #include <string.h>
 #include <errno.h>
+#include "highlight.h"
+#include "audio.h"
+
+#define MENU_MUSIC "palestine.mp3"
+#define GAME_MUSIC "music2.mp3"
+#define MUSIC_FADE_MS 1000
 
 typedef struct {
     SDL_Surface* image;
+    SDL_Surface* hover;     // generated from image when the button is created
     SDL_Rect position;
 } Button;
 
@@ -44,6 +51,7 @@ Button createButton(const char* imagePath, float scale) {
     }
     
     btn.image = resizeSurface(original, scale);
+    btn.hover = highlight_make(btn.image, HIGHLIGHT_BRIGHTEN);
     btn.position.x = 0;
     btn.position.y = 0;
     
@@ -51,6 +59,16 @@ Button createButton(const char* imagePath, float scale) {
     return btn;
 }
 
+void drawButton(SDL_Surface* screen, Button* btn, int mouseX, int mouseY) {
+    SDL_Surface* img = btn->image;
+    if (btn->hover &&
+        mouseX >= btn->position.x && mouseX <= btn->position.x + btn->image->w &&
+        mouseY >= btn->position.y && mouseY <= btn->position.y + btn->image->h) {
+        img = btn->hover;
+    }
+    SDL_BlitSurface(img, NULL, screen, &btn->position);
+}
+
 void fadeTransition(SDL_Surface* screen, SDL_Surface* from, SDL_Surface* to, int duration_ms) {
     const int steps = 30;
     const int delay = duration_ms / steps;
@@ -67,14 +85,9 @@ void fadeTransition(SDL_Surface* screen, SDL_Surface* from, SDL_Surface* to, int
     }
 }
 
-void startGame(SDL_Surface* screen) {
-    Mix_HaltMusic();
-    Mix_Music* gameMusic = Mix_LoadMUS("music2.mp3");
-    if(!gameMusic) {
-        printf("Failed to load game music: %s\n", Mix_GetError());
-    } else {
-        Mix_PlayMusic(gameMusic, -1);
-    }
+void startGame(SDL_Surface* screen, AudioManager* audio) {
+    // Prefetched at startup, so this only starts the crossfade
+    audio_play(audio, GAME_MUSIC);
 
     pid_t pid = fork();
     if (pid == 0) {
@@ -89,25 +102,17 @@ void startGame(SDL_Surface* screen) {
     else if (pid > 0) {
         int status;
         waitpid(pid, &status, 0);
-        
-        if(gameMusic) {
-            Mix_HaltMusic();
-            Mix_FreeMusic(gameMusic);
-        }
+
+        audio_play(audio, MENU_MUSIC);
     }
     else {
         printf("Failed to fork: %s\n", strerror(errno));
     }
 }
 
-void startOptionProgram(SDL_Surface* screen) {
-    Mix_HaltMusic();
-    Mix_Music* gameMusic = Mix_LoadMUS("music2.mp3");
-    if(!gameMusic) {
-        printf("Failed to load game music: %s\n", Mix_GetError());
-    } else {
-        Mix_PlayMusic(gameMusic, -1);
-    }
+void startOptionProgram(SDL_Surface* screen, AudioManager* audio) {
+    // Prefetched at startup, so this only starts the crossfade
+    audio_play(audio, GAME_MUSIC);
 
     pid_t pid = fork();
     if (pid == 0) {
@@ -122,11 +127,8 @@ void startOptionProgram(SDL_Surface* screen) {
     else if (pid > 0) {
         int status;
         waitpid(pid, &status, 0);
-        
-        if(gameMusic) {
-            Mix_HaltMusic();
-            Mix_FreeMusic(gameMusic);
-        }
+
+        audio_play(audio, MENU_MUSIC);
     }
     else {
         printf("Failed to fork: %s\n", strerror(errno));
@@ -147,12 +149,11 @@ int main(int argc, char* argv[]) {
     IMG_Init(IMG_INIT_JPG | IMG_INIT_PNG);
     Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048);
 
-    Mix_Music* music = Mix_LoadMUS("palestine.mp3");
-    if(!music) {
-        printf("Failed to load menu music: %s\n", Mix_GetError());
-    } else {
-        Mix_PlayMusic(music, -1);
-    }
+    // Music is decoded in the background; the game track is ready before it is needed
+    AudioManager audio;
+    audio_init(&audio, MUSIC_FADE_MS);
+    audio_play(&audio, MENU_MUSIC);
+    audio_prefetch(&audio, GAME_MUSIC);
 
     SDL_Surface* menu1 = IMG_Load("back.jpeg");
     SDL_Surface* menu2 = IMG_Load("menu2.png");
@@ -243,7 +244,7 @@ int main(int argc, char* argv[]) {
                             mouseX <= optionBtn.position.x + optionBtn.image->w &&
                             mouseY >= optionBtn.position.y && 
                             mouseY <= optionBtn.position.y + optionBtn.image->h) {
-                        startOptionProgram(screen);
+                        startOptionProgram(screen, &audio);
                     }
                     else if(mouseX >= histoireBtn.position.x && 
                             mouseX <= histoireBtn.position.x + histoireBtn.image->w &&
@@ -304,17 +305,20 @@ int main(int argc, char* argv[]) {
         }
         SDL_BlitSurface(bg, NULL, screen, NULL);
 
+        int mouseX, mouseY;
+        SDL_GetMouseState(&mouseX, &mouseY);
+
         if(currentScreen == 1) {
             // Draw main menu buttons vertically at bottom
-            SDL_BlitSurface(jouerBtn.image, NULL, screen, &jouerBtn.position);
-            SDL_BlitSurface(optionBtn.image, NULL, screen, &optionBtn.position);
-            SDL_BlitSurface(histoireBtn.image, NULL, screen, &histoireBtn.position);
-            SDL_BlitSurface(quitterBtn.image, NULL, screen, &quitterBtn.position);
+            drawButton(screen, &jouerBtn, mouseX, mouseY);
+            drawButton(screen, &optionBtn, mouseX, mouseY);
+            drawButton(screen, &histoireBtn, mouseX, mouseY);
+            drawButton(screen, &quitterBtn, mouseX, mouseY);
         }
         else if(currentScreen == 2) {
             // Draw page 2 buttons at bottom
-            SDL_BlitSurface(nvBtn.image, NULL, screen, &nvBtn.position);
-            SDL_BlitSurface(enBtn.image, NULL, screen, &enBtn.position);
+            drawButton(screen, &nvBtn, mouseX, mouseY);
+            drawButton(screen, &enBtn, mouseX, mouseY);
         }
         else if(currentScreen == 3) {
             Uint32 now = SDL_GetTicks();
@@ -332,7 +336,7 @@ int main(int argc, char* argv[]) {
             if (now - startLoadingTime >= 5000) {
                 fadeTransition(screen, menu3, menu4, 500);
                 currentScreen = 4;
-                startGame(screen);
+                startGame(screen, &audio);
                 quit = 1;
             }
         }
@@ -352,10 +356,17 @@ int main(int argc, char* argv[]) {
     SDL_FreeSurface(quitterBtn.image);
     SDL_FreeSurface(nvBtn.image);
     SDL_FreeSurface(enBtn.image);
+    SDL_FreeSurface(jouerBtn.hover);
+    SDL_FreeSurface(optionBtn.hover);
+    SDL_FreeSurface(histoireBtn.hover);
+    SDL_FreeSurface(quitterBtn.hover);
+    SDL_FreeSurface(nvBtn.hover);
+    SDL_FreeSurface(enBtn.hover);
     for (int i = 0; i < LOADING_FRAMES; i++) {
         SDL_FreeSurface(loadingFrames[i]);
     }
-    Mix_FreeMusic(music);
+    audio_report(&audio, stdout);
+    audio_shutdown(&audio);
     Mix_CloseAudio();
     IMG_Quit();
     SDL_Quit();